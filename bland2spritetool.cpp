@@ -1,904 +1,633 @@
 #define _CRT_SECURE_NO_WARNINGS //Shut up Visual Studio
-#include <stdio.h>
-#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 #include <iostream>
+#include <fstream>
 #include <string>
 #include <vector>
-#include <unordered_map>
-#include "tinyxml2.h"
-
-struct AnimFrame {
-    std::string sprite_name;
-    uint8_t delay;
-    uint8_t max_delay; //Must be greater than delay to apply delay randomization
-    float x_scale;
-    float y_scale;
-    float x;
-    float y;
-    int16_t angle; //0-4095 equivalent to a circle
-};
-
-struct Image {
-    uint16_t texture_id;
-    uint16_t num_palettes; //Treated as consecutive texture_ids starting from texture_id
-    int16_t x;
-    int16_t y;
-    uint16_t src_x;
-    uint16_t src_y;
-    uint16_t w;
-    uint16_t h;
-    uint8_t alpha_mode; //0=100% alpha, 1=75% alpha, 2=50% alpha, 3=25% alpha
-    int16_t angle; //0-4095 equivalent to a circle
-    uint8_t blend_mode; //0=normal, 1=additive, 2=mask, 3=none
-    bool bilinear;
-    uint8_t flip; //0x1=x-flip, 0x2=y-flip
-};
-
-struct Sprite {
-    std::string name;
-    int16_t min_x;
-    int16_t min_y;
-    int16_t max_x;
-    int16_t max_y;
-    std::vector<Image> images;
-};
-
-struct SpriteHeader {
-    uint16_t sprite_count;
-    uint16_t anim_count;
-    uint16_t frame_count;
-    uint16_t image_count;
-    uint32_t sprite_ofs;
-    uint32_t anim_ofs;
-    uint32_t frame_ofs;
-    uint32_t image_ofs;
-};
-
-std::vector<std::vector<AnimFrame>> anim_list;
-std::vector<Sprite> sprite_list;
-
-void XMLCheck(tinyxml2::XMLError error)
-{
-    if (error != tinyxml2::XML_SUCCESS) {
-        //Terminate if not successful
-        std::cout << "tinyxml2 error " << tinyxml2::XMLDocument::ErrorIDToName(error) << std::endl;
-        exit(1);
+#include <filesystem>
+#include <algorithm>
+#include <cctype>
+#include <unordered_set>
+#include <deque>
+#include <mutex>
+#include <new>
+#include "spritelib.h"
+#include "parallel.h"
+
+//Allocations go through malloc so -mem-report can count them, sizes are only looked up while tracking is on
+void *operator new(size_t size)
+{
+    void *ptr = malloc(size ? size : 1);
+    if (!ptr) {
+        throw std::bad_alloc();
     }
-}
-
-tinyxml2::XMLError QueryAttributeU8(tinyxml2::XMLElement *element, const char *name, uint8_t *value)
-{
-    uint32_t temp;
-    tinyxml2::XMLError error = element->QueryAttribute(name, &temp);
-    if (error == tinyxml2::XML_SUCCESS) {
-        //Write value if successful
-        *value = temp;
+    if (IsAllocationTrackingEnabled()) {
+        CountAllocation(GetAllocationSize(ptr));
     }
-    return error;
+    return ptr;
 }
 
-tinyxml2::XMLError QueryAttributeU16(tinyxml2::XMLElement *element, const char *name, uint16_t *value)
+void *operator new[](size_t size)
 {
-    uint32_t temp;
-    tinyxml2::XMLError error = element->QueryAttribute(name, &temp);
-    if (error == tinyxml2::XML_SUCCESS) {
-        //Write value if successful
-        *value = temp;
-    }
-    return error;
+    return operator new(size);
 }
 
-tinyxml2::XMLError QueryAttributeS16(tinyxml2::XMLElement *element, const char *name, int16_t *value)
+void *operator new(size_t size, const std::nothrow_t &) noexcept
 {
-    int32_t temp;
-    tinyxml2::XMLError error = element->QueryAttribute(name, &temp);
-    if (error == tinyxml2::XML_SUCCESS) {
-        //Write value if successful
-        *value = temp;
+    void *ptr = malloc(size ? size : 1);
+    if (ptr && IsAllocationTrackingEnabled()) {
+        CountAllocation(GetAllocationSize(ptr));
     }
-    return error;
-}
-
-void SetSeek(FILE *file, size_t ofs)
-{
-    fseek(file, ofs, SEEK_SET);
-}
-
-size_t GetSeek(FILE *file)
-{
-    return ftell(file);
-}
-
-void FileSkip(FILE *file, size_t bytes)
-{
-    fseek(file, bytes, SEEK_CUR);
-}
-
-size_t GetFileSize(FILE *file)
-{
-    //Seek to end and restore file pointer
-    size_t old_seek = GetSeek(file);
-    fseek(file, 0, SEEK_END);
-    size_t size = ftell(file);
-    SetSeek(file, old_seek);
-    return size;
-}
-
-uint8_t ReadU8(FILE *file)
-{
-    uint8_t temp;
-    fread(&temp, 1, 1, file);
-    return temp;
-}
-
-int8_t ReadS8(FILE *file)
-{
-    //Same as reading unsigned version
-    return ReadU8(file);
-}
-
-bool ReadBool(FILE *file)
-{
-    //Bools are implemented as unsigned 8-bit integers in c++
-    return ReadU8(file);
-}
-
-uint16_t ReadU16(FILE *file)
-{
-    uint8_t temp[2];
-    fread(&temp, 1, 2, file);
-    //Return bytes in little-endian order
-    return (temp[1] << 8) | temp[0];
-}
-
-int16_t ReadS16(FILE *file)
-{
-    return ReadU16(file);
-}
-
-uint32_t ReadU32(FILE *file)
-{
-    uint8_t temp[4];
-    fread(&temp, 1, 4, file);
-    //Return bytes in little-endian order
-    return (temp[3] << 24) | (temp[2] << 16) | (temp[1] << 8) | temp[0];
+    return ptr;
 }
 
-int32_t ReadS32(FILE *file)
+void *operator new[](size_t size, const std::nothrow_t &tag) noexcept
 {
-    return ReadU32(file);
+    return operator new(size, tag);
 }
 
-float ReadFloat(FILE *file)
+void operator delete(void *ptr) noexcept
 {
-    int32_t raw = ReadS32(file);
-    return *(float *)(&raw); //Reinterpret 4 bytes as float
-}
-
-void WriteU8(FILE *file, uint8_t value)
-{
-    fwrite(&value, 1, 1, file);
+    if (ptr && IsAllocationTrackingEnabled()) {
+        CountFree(GetAllocationSize(ptr));
+    }
+    free(ptr);
 }
 
-void WriteS8(FILE *file, int8_t value)
+void operator delete[](void *ptr) noexcept
 {
-    fwrite(&value, 1, 1, file);
+    operator delete(ptr);
 }
 
-void WriteBool(FILE *file, bool value)
+void operator delete(void *ptr, size_t) noexcept
 {
-    //Bools are implemented as 8-bit integers in c++
-    WriteU8(file, value);
+    operator delete(ptr);
 }
 
-void WriteU16(FILE *file, uint16_t value)
+void operator delete[](void *ptr, size_t) noexcept
 {
-    uint8_t temp[2];
-    //Write bytes in little-endian order
-    temp[1] = value >> 8;
-    temp[0] = value & 0xFF;
-    fwrite(temp, 2, 1, file);
+    operator delete(ptr);
 }
 
-void WriteS16(FILE *file, int16_t value)
+void operator delete(void *ptr, const std::nothrow_t &) noexcept
 {
-    int8_t temp[2];
-    //Write bytes in little-endian order
-    temp[1] = value >> 8;
-    temp[0] = value & 0xFF;
-    fwrite(temp, 2, 1, file);
+    operator delete(ptr);
 }
 
-void WriteU32(FILE *file, uint32_t value)
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept
 {
-    uint8_t temp[4];
-    //Write bytes in little-endian order
-    temp[3] = value >> 24;
-    temp[2] = (value >> 16) & 0xFF;
-    temp[1] = (value >> 8) & 0xFF;
-    temp[0] = value & 0xFF;
-    fwrite(temp, 4, 1, file);
+    operator delete(ptr);
 }
 
-void WriteS32(FILE *file, int32_t value)
-{
-    int8_t temp[4];
-    //Write bytes in little-endian order
-    temp[3] = value >> 24;
-    temp[2] = (value >> 16) & 0xFF;
-    temp[1] = (value >> 8) & 0xFF;
-    temp[0] = value & 0xFF;
-    fwrite(temp, 4, 1, file);
-}
+enum ToolMode {
+    MODE_DUMP, //Sprite file to XML, JSON, or sprite project file
+    MODE_BUILD, //XML, JSON, or sprite project file to sprite file
+    MODE_CONVERT //Between XML, JSON, and sprite project files
+};
 
-void WriteFloat(FILE *file, float value)
-{
-    WriteS32(file, *(int32_t *)&value); //Write the bits of the float to the file
-}
+struct ToolOptions {
+    unsigned num_threads; //Threads used by -batch, -mirror, and single large builds
+    std::string cache_dir; //Build cache directory, empty to disable
+    bool print_stats; //Print phase times and counts after converting
+    std::string stats_json_file; //File to write phase times and counts to as JSON, empty to disable
+    std::string trace_file; //File to write Chrome trace of files and phases to, empty to disable
+    TraceRecorder *trace; //Recorder shared by all conversions if tracing
+    bool perf_counters; //Add hardware counters to statistics
+    bool mem_report; //Add heap allocations and peak memory to statistics
+};
 
-void ReadSpriteHeader(FILE *file, SpriteHeader &header)
-{
-    //Read count fields
-    header.sprite_count = ReadU16(file);
-    header.anim_count = ReadU16(file);
-    header.frame_count = ReadU16(file);
-    header.image_count = ReadU16(file);
-    //Read offset fields
-    header.sprite_ofs = ReadU32(file);
-    header.anim_ofs = ReadU32(file);
-    header.frame_ofs = ReadU32(file);
-    header.image_ofs = ReadU32(file);
+bool ParseOptions(std::vector<std::string> &args, ToolOptions &options)
+{
+    options.num_threads = GetDefaultThreadCount();
+    options.cache_dir = "";
+    options.print_stats = false;
+    options.stats_json_file = "";
+    options.trace_file = "";
+    options.trace = nullptr;
+    options.perf_counters = false;
+    options.mem_report = false;
+    //Remove options and keep remaining arguments in order
+    std::vector<std::string> remaining;
+    for (size_t i = 0; i < args.size(); i++) {
+        if (args[i] == "-j" && i + 1 < args.size()) {
+            //Read thread count
+            options.num_threads = strtoul(args[++i].c_str(), nullptr, 10);
+            if (options.num_threads == 0) {
+                std::cout << "Invalid thread count " << args[i] << "." << std::endl;
+                return false;
+            }
+        } else if (args[i] == "-cache" && i + 1 < args.size()) {
+            options.cache_dir = args[++i];
+        } else if (args[i] == "-stats") {
+            options.print_stats = true;
+        } else if (args[i] == "-stats-json" && i + 1 < args.size()) {
+            options.stats_json_file = args[++i];
+        } else if (args[i] == "-perf-counters") {
+            options.perf_counters = true;
+        } else if (args[i] == "-mem-report") {
+            options.mem_report = true;
+        } else if (args[i] == "-trace" && i + 1 < args.size()) {
+            options.trace_file = args[++i];
+        } else {
+            remaining.push_back(args[i]);
+        }
+    }
+    args = remaining;
+    if (options.mem_report) {
+        EnableAllocationTracking();
+        //Report is printed unless statistics are already going somewhere
+        if (options.stats_json_file.empty()) {
+            options.print_stats = true;
+        }
+    }
+    return true;
 }
 
-bool VerifySpriteHeader(SpriteHeader &header, size_t file_size)
+std::string GetDerivedName(std::string in_file, std::string extension)
 {
-    //Check if end of each section exceeds end of file
-    bool anim_valid = ((header.anim_ofs) + (4 * header.anim_count)) <= file_size;
-    bool frame_valid = ((header.frame_ofs) + (28 * header.frame_count)) <= file_size;
-    bool sprite_valid = ((header.sprite_ofs) + (12 * header.sprite_count)) <= file_size;
-    bool image_valid = ((header.image_ofs) + (28 * header.image_count)) <= file_size;
-    return anim_valid && frame_valid && sprite_valid && image_valid;
+    //Replace extension of input name
+    std::string out_name = in_file.substr(0, in_file.find_last_of('.'));
+    return out_name + extension;
 }
 
-void ReadAnims(FILE *file, SpriteHeader &header)
+bool HasExtension(const std::filesystem::path &path, const char *extension)
 {
-    //Seek to animations
-    SetSeek(file, header.anim_ofs);
-    for (uint16_t i = 0; i < header.anim_count; i++) {
-        //Read animation frame range
-        uint16_t start_frame = ReadU16(file);
-        uint16_t num_frames = ReadU16(file);
-        std::vector<AnimFrame> anim;
-        size_t old_seek = GetSeek(file);
-        //Read frames for each animation
-        SetSeek(file, header.frame_ofs + (start_frame * 28));
-        for (uint16_t j = 0; j < num_frames; j++) {
-            AnimFrame frame;
-            //Read sprite index
-            uint16_t sprite_idx = ReadU16(file);
-            //Convert sprite index to name
-            frame.sprite_name = "sprite" + std::to_string(sprite_idx);
-            //Read delay fields
-            frame.delay = ReadU8(file);
-            frame.max_delay = ReadU8(file);
-            //Read scale fields
-            frame.x_scale = ReadFloat(file);
-            frame.y_scale = ReadFloat(file);
-            //Read position fields
-            frame.x = ReadFloat(file);
-            frame.y = ReadFloat(file);
-            //Read angle
-            frame.angle = ReadS16(file);
-            FileSkip(file, 6); //Skip animation ID, next frame, and padding field
-            anim.push_back(frame); //Add frame to animation
+    std::string path_extension = path.extension().u8string();
+    if (path_extension.size() != strlen(extension)) {
+        return false;
+    }
+    //Extensions are compared without case
+    for (size_t i = 0; i < path_extension.size(); i++) {
+        if (tolower((unsigned char)path_extension[i]) != extension[i]) {
+            return false;
         }
-        //Enable reading next animation
-        SetSeek(file, old_seek);
-        anim_list.push_back(anim);
     }
+    return true;
 }
 
-void ReadSprites(FILE *file, SpriteHeader &header)
+std::string GetOutputExtension(ToolMode mode, std::string in_file)
 {
-    SetSeek(file, header.sprite_ofs);
-    for (uint16_t i = 0; i < header.sprite_count; i++) {
-        Sprite sprite;
-        //Read sprite image ranges
-        uint16_t start_image = ReadU16(file);
-        uint16_t num_images = ReadU16(file);
-        //Convert sprite index to name
-        sprite.name = "sprite" + std::to_string(i);
-        //Read sprite bounding rectangle
-        sprite.min_x = ReadS16(file);
-        sprite.min_y = ReadS16(file);
-        sprite.max_x = ReadS16(file);
-        sprite.max_y = ReadS16(file);
-        size_t old_seek = GetSeek(file);
-        //Read images for sprite
-        SetSeek(file, header.image_ofs + (start_image * 28));
-        for (uint16_t j = 0; j < num_images; j++) {
-            Image image;
-            image.texture_id = ReadU16(file); //Read texture ID
-            image.num_palettes = ReadU16(file); //Read palette count
-            //Read image position
-            image.x = ReadS16(file);
-            image.y = ReadS16(file);
-            //Read image source position
-            image.src_x = ReadU16(file);
-            image.src_y = ReadU16(file);
-            //Read image size
-            image.w = ReadU16(file);
-            image.h = ReadU16(file);
-            FileSkip(file, 1); //Skip unknown field
-            image.alpha_mode = ReadU8(file); //Read image alpha mode
-            FileSkip(file, 2); //Skip 2 unknown fields
-            image.angle = ReadS16(file); //Read image angle
-            image.blend_mode = ReadU8(file); //Read image blend mode
-            image.bilinear = ReadBool(file); //Read image bilinear filter flag
-            image.flip = ReadU8(file); //Read image flip flags
-            FileSkip(file, 3); //Skip 3 unknown fields
-            sprite.images.push_back(image);
-        }
-        SetSeek(file, old_seek); //Enable reading next sprite
-        sprite_list.push_back(sprite);
+    if (mode == MODE_DUMP) {
+        return ".xml";
+    } else if (mode == MODE_BUILD) {
+        return ".spr";
     }
+    //Convert to whichever format input is not in
+    return HasExtension(std::filesystem::u8path(in_file), ".sprj") ? ".xml" : ".sprj";
 }
 
-float GetImageAlpha(uint8_t value)
+SpriteFormat GetOutputFormat(std::string out_file)
 {
-    if (value >= 4) {
-        //Game treats image modes greater than 4 as full alpha
-        return 1.0f;
+    //Output format is chosen by extension
+    std::filesystem::path path = std::filesystem::u8path(out_file);
+    if (HasExtension(path, ".json")) {
+        return SPRITE_FORMAT_JSON;
+    } else if (HasExtension(path, ".sprj")) {
+        return SPRITE_FORMAT_PROJECT;
     }
-    //Game treats values 0-3 as 100% to 25%
-    return (4 - value) * 0.25f;
+    return SPRITE_FORMAT_XML;
 }
 
-uint8_t GetAlphaModeValue(float alpha)
+bool ConvertFile(ConversionContext &context, const ToolOptions &options, ToolMode mode, std::string in_file, std::string out_file)
 {
-    //Use midpoint check for alpha value
-    if (alpha > 0.875f) {
-        return 0;
-    } else if (alpha > 0.625f) {
-        return 1;
-    } else if (alpha > 0.375f) {
-        return 2;
+    context.cache_dir = options.cache_dir;
+    context.trace = options.trace;
+    context.perf_counters = options.perf_counters;
+    context.mem_report = options.mem_report;
+    if (mode == MODE_DUMP) {
+        return DumpSprite(context, in_file, out_file, GetOutputFormat(out_file));
+    } else if (mode == MODE_BUILD) {
+        return BuildSprite(context, in_file, out_file);
     } else {
-        return 3;
+        return ConvertProject(context, in_file, out_file, GetOutputFormat(out_file));
     }
 }
 
-uint8_t GetBlendModeValue(const char *name)
-{
-    std::string name_temp = name;
-    std::string mode_names[3] = { "normal", "additive", "mask" };
-    for (size_t i = 0; i < 3; i++) {
-        if (name_temp == mode_names[i]) {
-            //Found blend mode with proper name
-            return i;
+bool MatchWildcard(const char *pattern, const char *name)
+{
+    //Position to retry from after last *
+    const char *star_pattern = nullptr;
+    const char *star_name = nullptr;
+    while (*name) {
+        if (*pattern == '*') {
+            //Let * match nothing first
+            star_pattern = pattern++;
+            star_name = name;
+        } else if (*pattern == '?' || *pattern == *name) {
+            pattern++;
+            name++;
+        } else if (star_pattern) {
+            //Let last * match one more character
+            pattern = star_pattern + 1;
+            name = ++star_name;
+        } else {
+            return false;
         }
     }
-    //Use none blend mode if not found
-    return 3;
-}
-
-const char *GetBlendModeName(uint8_t value)
-{
-    const char *names[3] = { "normal", "additive", "mask" };
-    if (value >= 3) {
-        //Replace invalid blend modes with none
-        return "none";
+    //Only trailing *s can match the end of the name
+    while (*pattern == '*') {
+        pattern++;
     }
-    //Read blend mode name from table
-    return names[value];
+    return *pattern == '\0';
 }
 
-void WriteSpriteXML(std::string out_file)
+bool ExpandInput(std::string input, std::vector<std::string> &inputs, bool allow_list, std::string &error)
 {
-    tinyxml2::XMLDocument document;
-    //Add root element
-    tinyxml2::XMLElement *root = document.NewElement("spritedata");
-    document.InsertFirstChild(root);
-    //Write animation sequences
-    for (size_t i = 0; i < anim_list.size(); i++) {
-        tinyxml2::XMLElement *anim_root = document.NewElement("anim");
-        //Write animation frames
-        for (size_t j = 0; j < anim_list[i].size(); j++) {
-            tinyxml2::XMLElement *frame = document.NewElement("frame");
-            //Write sprite name
-            frame->SetAttribute("sprite", anim_list[i][j].sprite_name.c_str());
-            //Write non-default delay
-            if (anim_list[i][j].delay != 1) {
-                frame->SetAttribute("delay", anim_list[i][j].delay);
-            }
-            //Write non-default max delay
-            if (anim_list[i][j].max_delay != 0) {
-                frame->SetAttribute("delay_range", anim_list[i][j].max_delay);
-            }
-            //Write non-default scale
-            if (anim_list[i][j].x_scale != 1.0f) {
-                frame->SetAttribute("x_scale", anim_list[i][j].x_scale);
-            }
-            if (anim_list[i][j].y_scale != 1.0f) {
-                frame->SetAttribute("y_scale", anim_list[i][j].y_scale);
-            }
-            //Write non-default position
-            if (anim_list[i][j].x != 0.0f) {
-                frame->SetAttribute("x", anim_list[i][j].x);
-            }
-            if (anim_list[i][j].y != 0.0f) {
-                frame->SetAttribute("y", anim_list[i][j].y);
-            }
-            //Write non-default angle
-            if (anim_list[i][j].angle != 0) {
-                frame->SetAttribute("angle", anim_list[i][j].angle);
-            }
-            //Add animation frame to animation
-            anim_root->InsertEndChild(frame);
+    if (allow_list && input.size() > 1 && input[0] == '@') {
+        //Read input list with one input per line
+        std::ifstream list(input.substr(1));
+        if (!list) {
+            error = "Failed to open " + input.substr(1) + " for reading.";
+            return false;
         }
-        //Add animation to XML
-        root->InsertEndChild(anim_root);
-    }
-    //Write sprites
-    for (size_t i = 0; i < sprite_list.size(); i++) {
-        tinyxml2::XMLElement *sprite = document.NewElement("sprite");
-        //Write sprite name
-        sprite->SetAttribute("name", sprite_list[i].name.c_str());
-        //Write sprite images
-        for (size_t j = 0; j < sprite_list[i].images.size(); j++) {
-            tinyxml2::XMLElement *image = document.NewElement("image");
-            image->SetAttribute("texture_id", sprite_list[i].images[j].texture_id);
-            //Write number of palettes if more than 1
-            if (sprite_list[i].images[j].num_palettes > 1) {
-                image->SetAttribute("num_palettes", sprite_list[i].images[j].num_palettes);
-            }
-            //Write source position of image
-            image->SetAttribute("src_x", sprite_list[i].images[j].src_x);
-            image->SetAttribute("src_y", sprite_list[i].images[j].src_y);
-            //Write position of image
-            image->SetAttribute("x", sprite_list[i].images[j].x);
-            image->SetAttribute("y", sprite_list[i].images[j].y);
-            //Write size of image
-            image->SetAttribute("w", sprite_list[i].images[j].w);
-            image->SetAttribute("h", sprite_list[i].images[j].h);
-            //Write non-default alpha mode
-            if (sprite_list[i].images[j].alpha_mode != 0) {
-                image->SetAttribute("alpha", GetImageAlpha(sprite_list[i].images[j].alpha_mode));
-            }
-            //Write non-zero angle
-            if (sprite_list[i].images[j].angle != 0) {
-                image->SetAttribute("angle", sprite_list[i].images[j].angle);
-            }
-            //Write non-default blend mode
-            if (sprite_list[i].images[j].blend_mode != 0) {
-                image->SetAttribute("blend_mode", GetBlendModeName(sprite_list[i].images[j].blend_mode));
-            }
-            //Write bilinear flag if used
-            if (sprite_list[i].images[j].bilinear) {
-                image->SetAttribute("bilinear", sprite_list[i].images[j].bilinear);
-            }
-            //Write flip flags
-            if (sprite_list[i].images[j].flip & 0x1) {
-                image->SetAttribute("flip_x", (sprite_list[i].images[j].flip & 0x1) != 0);
+        std::string line;
+        while (std::getline(list, line)) {
+            //Trim whitespace and line endings
+            size_t start = line.find_first_not_of(" \t\r\n");
+            if (start == std::string::npos) {
+                continue;
             }
-            if (sprite_list[i].images[j].flip & 0x2) {
-                image->SetAttribute("flip_y", (sprite_list[i].images[j].flip & 0x2) != 0);
+            size_t end = line.find_last_not_of(" \t\r\n");
+            if (!ExpandInput(line.substr(start, end - start + 1), inputs, false, error)) {
+                return false;
             }
-            //Add image to sprite
-            sprite->InsertEndChild(image);
         }
-        //Add sprite to XML
-        root->InsertEndChild(sprite);
+        return true;
     }
-    //Write out XML
-    XMLCheck(document.SaveFile(out_file.c_str()));
+    std::filesystem::path path = std::filesystem::u8path(input);
+    std::string pattern = path.filename().u8string();
+    if (pattern.find_first_of("*?") == std::string::npos) {
+        //Plain file name
+        inputs.push_back(input);
+        return true;
+    }
+    //Expand wildcards in file name
+    std::filesystem::path dir = path.parent_path();
+    std::vector<std::string> matches;
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(dir.empty() ? "." : dir, ec), end; !ec && it != end; it.increment(ec)) {
+        std::string name = it->path().filename().u8string();
+        if (it->is_regular_file(ec) && MatchWildcard(pattern.c_str(), name.c_str())) {
+            matches.push_back((dir / it->path().filename()).u8string());
+        }
+    }
+    if (matches.empty()) {
+        error = "No files match " + input + ".";
+        return false;
+    }
+    //Directory order is not stable so sort matches
+    std::sort(matches.begin(), matches.end());
+    inputs.insert(inputs.end(), matches.begin(), matches.end());
+    return true;
 }
 
-void DumpSprite(std::string in_file, std::string out_file)
+void PrintWarnings(std::string prefix, const std::vector<std::string> &warnings)
 {
-    //Try to open file
-    FILE *file = fopen(in_file.c_str(), "rb");
-    if (!file) {
-        //Die if failed to open
-        std::cout << "Failed to open " << in_file << " for reading." << std::endl;
-        exit(1);
-    }
-    //Read and verify sprite header
-    SpriteHeader header;
-    ReadSpriteHeader(file, header);
-    if (!VerifySpriteHeader(header, GetFileSize(file))) {
-        //Die if verification fails
-        std::cout << "Invalid sprite file." << std::endl;
-        exit(1);
-    }
-    //Read animation and sprite data
-    ReadAnims(file, header);
-    ReadSprites(file, header);
-    fclose(file);
-    //Write output
-    WriteSpriteXML(out_file);
+    for (size_t i = 0; i < warnings.size(); i++) {
+        std::cout << prefix << "Warning: " << warnings[i] << std::endl;
+    }
 }
 
-void ParseSprites(tinyxml2::XMLDocument &document, tinyxml2::XMLElement *root)
+void PrintSummary(size_t num_converted, size_t num_files, size_t num_cached, const ToolOptions &options)
 {
-    //Iterate through sprite elements in XML
-    tinyxml2::XMLElement *sprite_element = root->FirstChildElement("sprite");
-    while (sprite_element) {
-        Sprite sprite;
-        //Query sprite name
-        const char *sprite_name;
-        XMLCheck(sprite_element->QueryAttribute("name", &sprite_name));
-        sprite.name = sprite_name;
-        sprite.min_x = sprite.min_y = sprite.max_x = sprite.max_y = 0; //Zero out sprite rectangle
-        //Iterate through image elements in XML
-        tinyxml2::XMLElement *image_element = sprite_element->FirstChildElement("image"); 
-        while (image_element) {
-            Image image;
-            float alpha_value = 1.0f; //Image is opaque
-            const char *blend_mode_name = "normal"; //Use normal blend mode by default
-            bool flip_x = false; //No X-Flip by default
-            bool flip_y = false; //No Y-Flip by default
-            //Query texture ID
-            XMLCheck(QueryAttributeU16(image_element, "texture_id", &image.texture_id));
-            //Query palette count
-            image.num_palettes = 1; //Always have base palette
-            QueryAttributeU16(image_element, "num_palettes", &image.num_palettes);
-            //Query position of image
-            XMLCheck(QueryAttributeS16(image_element, "x", &image.x));
-            XMLCheck(QueryAttributeS16(image_element, "y", &image.y));
-            //Query source position from texture
-            XMLCheck(QueryAttributeU16(image_element, "src_x", &image.src_x));
-            XMLCheck(QueryAttributeU16(image_element, "src_y", &image.src_y));
-            //Query size of image
-            XMLCheck(QueryAttributeU16(image_element, "w", &image.w));
-            XMLCheck(QueryAttributeU16(image_element, "h", &image.h));
-            //Query alpha mode
-            image_element->QueryAttribute("alpha", &alpha_value);
-            image.alpha_mode = GetAlphaModeValue(alpha_value);
-            //Query angle
-            image.angle = 0;
-            QueryAttributeS16(image_element, "angle", &image.angle);
-            //Query blend mode
-            image_element->QueryAttribute("blend_mode", &blend_mode_name);
-            image.blend_mode = GetBlendModeValue(blend_mode_name);
-            //Query bilinear field
-            image.bilinear = false;
-            image_element->QueryAttribute("bilinear", &image.bilinear);
-            //Query flip fields
-            image_element->QueryAttribute("flip_x", &flip_x);
-            image_element->QueryAttribute("flip_y", &flip_y);
-            image.flip = 0;
-            //Set X Flip bit if enabled
-            if (flip_x) {
-                image.flip |= 0x1;
-            }
-            //Set Y Flip bit if enabled
-            if (flip_y) {
-                image.flip |= 0x2;
-            }
-            //Add image to sprite image list
-            sprite.images.push_back(image);
-            image_element = image_element->NextSiblingElement("image"); //Next image
-        }
-        //Add sprite to global sprite list
-        sprite_list.push_back(sprite);
-        sprite_element = sprite_element->NextSiblingElement("sprite"); //Next sprite
+    std::cout << "Converted " << num_converted << " of " << num_files << " files";
+    if (!options.cache_dir.empty()) {
+        std::cout << " (" << num_cached << " from cache)";
     }
+    std::cout << "." << std::endl;
 }
 
-void ParseAnims(tinyxml2::XMLDocument &document, tinyxml2::XMLElement *root)
+bool WriteReports(const ToolOptions &options, const ConversionStats &stats)
 {
-    //Read animations
-    tinyxml2::XMLElement *anim_element = root->FirstChildElement("anim");
-    while (anim_element) {
-        std::vector<AnimFrame> anim;
-        //Read frames of animation
-        tinyxml2::XMLElement *frame_element = anim_element->FirstChildElement("frame");
-        while (frame_element) {
-            AnimFrame frame;
-            const char *sprite_name_value;
-            //Read frame sprite name
-            XMLCheck(frame_element->QueryAttribute("sprite", &sprite_name_value));
-            frame.sprite_name = sprite_name_value;
-            //Read frame delay
-            frame.delay = 1;
-            QueryAttributeU8(frame_element, "delay", &frame.delay);
-            //Read max delay
-            frame.max_delay = 0;
-            QueryAttributeU8(frame_element, "max_delay", &frame.max_delay);
-            //Read frame scale
-            frame.x_scale = frame.y_scale = 1.0f;
-            frame_element->QueryAttribute("x_scale", &frame.x_scale);
-            frame_element->QueryAttribute("y_scale", &frame.y_scale);
-            //Read frame position
-            frame.x = frame.y = 0.0f;
-            frame_element->QueryAttribute("x", &frame.x);
-            frame_element->QueryAttribute("y", &frame.y);
-            //Read frame angle
-            frame.angle = 0;
-            QueryAttributeS16(frame_element, "angle", &frame.angle);
-            //Add frame to animation
-            anim.push_back(frame);
-            //Go to next frame
-            frame_element = frame_element->NextSiblingElement("frame");
+    if (options.perf_counters && !stats.has_perf_counters) {
+        //Statistics are still reported without counters
+        std::cout << "Hardware counters are not available. " << GetPerfCounterError() << std::endl;
+    }
+    if (options.print_stats) {
+        std::string text;
+        PrintStatsText(stats, text);
+        std::cout << text;
+    }
+    if (!options.stats_json_file.empty()) {
+        std::string json;
+        PrintStatsJSON(stats, json);
+        if (!WriteOutputFile(options.stats_json_file, json.data(), json.size())) {
+            std::cout << "Failed to open " << options.stats_json_file << " for writing." << std::endl;
+            return false;
         }
-        //Add animation to global list
-        anim_list.push_back(anim);
-        //Go to next animation
-        anim_element = anim_element->NextSiblingElement("anim");
     }
-}
-
-bool FindSprite(std::string name, uint16_t *idx)
-{
-    for (size_t i = 0; i < sprite_list.size(); i++) {
-        if (sprite_list[i].name == name) {
-            //Write index if found
-            *idx = i;
-            return true;
+    if (options.trace) {
+        std::string json;
+        PrintTraceJSON(*options.trace, json);
+        if (!WriteOutputFile(options.trace_file, json.data(), json.size())) {
+            std::cout << "Failed to open " << options.trace_file << " for writing." << std::endl;
+            return false;
         }
     }
-    //Return false if not found
-    return false;
+    return true;
 }
 
-void CalcSpriteBoundingRects()
+int RunBatch(const ToolOptions &options, ToolMode mode, std::vector<std::string> args)
 {
-    for (size_t i = 0; i < sprite_list.size(); i++) {
-        int16_t min_x, max_x, min_y, max_y;
-        //Set defaults for bounding rect in sprite
-        min_x = min_y = INT16_MAX;
-        max_x = max_y = INT16_MIN;
-        for (size_t j = 0; j < sprite_list[i].images.size(); j++) {
-            //Get image rectangle
-            int16_t x = sprite_list[i].images[j].x;
-            int16_t y = sprite_list[i].images[j].y;
-            int16_t w = sprite_list[i].images[j].w;
-            int16_t h = sprite_list[i].images[j].h;
-            //Update bounding rect based on image rectangle
-            if (x < min_x) {
-                min_x = x;
-            }
-            if (y < min_y) {
-                min_y = y;
-            }
-            if ((x + w) > max_x) {
-                max_x = x + w;
-            }
-            if ((y + h) > max_y) {
-                max_y = y + h;
-            }
+    std::vector<std::string> inputs;
+    for (size_t i = 0; i < args.size(); i++) {
+        std::string error;
+        if (!ExpandInput(args[i], inputs, true, error)) {
+            std::cout << error << std::endl;
+            return 1;
         }
-        //Set sprite bounding rectangle
-        sprite_list[i].min_x = min_x;
-        sprite_list[i].min_y = min_y;
-        sprite_list[i].max_x = max_x;
-        sprite_list[i].max_y = max_y;
     }
-}
-
-void CreateSpriteHeader(SpriteHeader &header)
-{
-    //Set sprite header info
-    header.sprite_ofs = 0x18;
-    header.sprite_count = sprite_list.size();
-    //Set animation header info
-    header.anim_ofs = header.sprite_ofs + (header.sprite_count * 12);
-    header.anim_count = anim_list.size();
-    //Set frame header info
-    header.frame_ofs = header.anim_ofs + (header.anim_count * 4);
-    //Calculate frame count
-    header.frame_count = 0;
-    for (size_t i = 0; i < anim_list.size(); i++) {
-        header.frame_count += anim_list[i].size();
-    }
-    //Set image header info
-    header.image_ofs = header.frame_ofs + (header.frame_count * 28);
-    //Calculate image count
-    header.image_count = 0;
-    for (size_t i = 0; i < sprite_list.size(); i++) {
-        header.image_count += sprite_list[i].images.size();
+    if (inputs.empty()) {
+        //Empty input lists would otherwise report success without converting anything
+        std::cout << "No input files matched." << std::endl;
+        return 1;
+    }
+    //Convert every input in its own context
+    std::vector<std::string> errors(inputs.size());
+    std::vector<char> success(inputs.size());
+    std::vector<char> cache_hit(inputs.size());
+    std::vector<std::vector<std::string>> warnings(inputs.size());
+    std::vector<ConversionStats> stats(inputs.size());
+    ParallelFor(inputs.size(), options.num_threads, [&](size_t i) {
+        ConversionContext context;
+        std::string out_file = GetDerivedName(inputs[i], GetOutputExtension(mode, inputs[i]));
+        success[i] = ConvertFile(context, options, mode, inputs[i], out_file);
+        cache_hit[i] = context.cache_hit;
+        errors[i] = context.error;
+        warnings[i] = context.warnings;
+        stats[i] = context.stats;
+    });
+    //Report warnings and failures in input order
+    size_t num_converted = 0;
+    size_t num_cached = 0;
+    ConversionStats total_stats = {};
+    for (size_t i = 0; i < inputs.size(); i++) {
+        AddConversionStats(total_stats, stats[i]);
+        PrintWarnings(inputs[i] + ": ", warnings[i]);
+        if (success[i]) {
+            num_converted++;
+        } else {
+            std::cout << inputs[i] << ": " << errors[i] << std::endl;
+        }
+        if (cache_hit[i]) {
+            num_cached++;
+        }
+    }
+    PrintSummary(num_converted, inputs.size(), num_cached, options);
+    if (!WriteReports(options, total_stats)) {
+        return 1;
     }
+    return (num_converted == inputs.size()) ? 0 : 1;
 }
 
-void WriteSpriteHeader(FILE *file, SpriteHeader &header)
-{
-    //Write count fields
-    WriteU16(file, header.sprite_count);
-    WriteU16(file, header.anim_count);
-    WriteU16(file, header.frame_count);
-    WriteU16(file, header.image_count);
-    //Write offset fields
-    WriteU32(file, header.sprite_ofs);
-    WriteU32(file, header.anim_ofs);
-    WriteU32(file, header.frame_ofs);
-    WriteU32(file, header.image_ofs);
-}
+struct MirrorResult {
+    std::string in_file;
+    std::string error;
+    std::vector<std::string> warnings;
+    bool success;
+    bool cache_hit;
+    ConversionStats stats;
+};
+
+struct MirrorState {
+    const ToolOptions *options;
+    ToolMode mode;
+    std::filesystem::path in_root;
+    std::filesystem::path out_root;
+    std::vector<const char *> in_extensions;
+    TaskScheduler scheduler;
+    std::mutex results_mutex; //Guards adding results, tasks write only their own result
+    std::deque<MirrorResult> results; //Results are referenced by tasks so must not move when walk adds more
+};
 
-void WriteSprites(FILE *file)
+MirrorResult &AddMirrorResult(MirrorState &state, std::string path, std::string error)
 {
-    uint16_t start_image = 0; //Start with image 0
-    //Loop over sprites
-    for (size_t i = 0; i < sprite_list.size(); i++) {
-        //Write image range
-        WriteU16(file, start_image);
-        WriteU16(file, sprite_list[i].images.size());
-        //Write bounding rectangle
-        WriteS16(file, sprite_list[i].min_x);
-        WriteS16(file, sprite_list[i].min_y);
-        WriteS16(file, sprite_list[i].max_x);
-        WriteS16(file, sprite_list[i].max_y);
-        //Get next starting image
-        start_image += sprite_list[i].images.size();
-    }
+    std::lock_guard<std::mutex> lock(state.results_mutex);
+    state.results.push_back(MirrorResult { path, error, {}, false, false, {} });
+    return state.results.back();
 }
 
-void WriteAnims(FILE *file)
+void ConvertMirrorFile(MirrorState &state, MirrorResult &result, std::filesystem::path out_path)
 {
-    uint16_t start_frame = 0; //Start with frame 0
-    //Loop over animations
-    for (size_t i = 0; i < anim_list.size(); i++) {
-        //Write animation frame range
-        WriteU16(file, start_frame);
-        WriteU16(file, anim_list[i].size());
-        //Get next starting frame
-        start_frame += anim_list[i].size();
-    }
+    std::error_code dir_ec;
+    std::filesystem::create_directories(out_path.parent_path(), dir_ec);
+    ConversionContext context;
+    result.success = ConvertFile(context, *state.options, state.mode, result.in_file, out_path.u8string());
+    result.cache_hit = context.cache_hit;
+    result.error = context.error;
+    result.warnings = context.warnings;
+    result.stats = context.stats;
 }
 
-void WriteAnimFrames(FILE *file)
+void WalkMirrorDirectory(MirrorState &state, std::filesystem::path dir)
 {
-    //Loop over animation frames
-    for (size_t i = 0; i < anim_list.size(); i++) {
-        for (size_t j = 0; j < anim_list[i].size(); j++) {
-            //Write sprite index corresponding to sprite name
-            uint16_t sprite_idx;
-            FindSprite(anim_list[i][j].sprite_name, &sprite_idx);
-            WriteU16(file, sprite_idx);
-            //Write delay fields
-            WriteU8(file, anim_list[i][j].delay);
-            WriteU8(file, anim_list[i][j].max_delay);
-            //Write scale fields
-            WriteFloat(file, anim_list[i][j].x_scale);
-            WriteFloat(file, anim_list[i][j].y_scale);
-            //Write position fields
-            WriteFloat(file, anim_list[i][j].x);
-            WriteFloat(file, anim_list[i][j].y);
-            //Write angle
-            WriteS16(file, anim_list[i][j].angle);
-            WriteS16(file, i); //Animation index
-            WriteS16(file, (j + 1) % anim_list[i].size()); //Next frame
-            //Write dummy field needed for matching
-            WriteS16(file, 1);
+    //Walk failures are reported with conversion failures so the run fails
+    std::vector<std::filesystem::path> sub_dirs;
+    std::vector<std::pair<std::filesystem::path, uintmax_t>> files;
+    //Entries get their own error codes so one bad entry does not end listing of the rest
+    std::error_code list_ec;
+    for (std::filesystem::directory_iterator it(dir, list_ec), end; !list_ec && it != end; it.increment(list_ec)) {
+        std::error_code status_ec;
+        std::filesystem::file_status status = it->status(status_ec);
+        if (status_ec) {
+            AddMirrorResult(state, it->path().u8string(), "Failed to read file status. " + status_ec.message());
+            continue;
+        }
+        if (std::filesystem::is_directory(status)) {
+            //Links to directories may point back up the tree and never end the walk
+            std::error_code link_ec;
+            bool is_link = it->is_symlink(link_ec);
+            if (link_ec) {
+                AddMirrorResult(state, it->path().u8string(), "Failed to read file status. " + link_ec.message());
+            } else if (!is_link) {
+                sub_dirs.push_back(it->path());
+            }
+        } else if (std::filesystem::is_regular_file(status)) {
+            for (size_t i = 0; i < state.in_extensions.size(); i++) {
+                if (!HasExtension(it->path(), state.in_extensions[i])) {
+                    continue;
+                }
+                std::error_code size_ec;
+                uintmax_t size = it->file_size(size_ec);
+                if (size_ec) {
+                    AddMirrorResult(state, it->path().u8string(), "Failed to read file size. " + size_ec.message());
+                } else {
+                    files.emplace_back(it->path(), size);
+                }
+            }
         }
     }
-}
-
-void WriteImages(FILE *file)
-{
-    //Loop over images
-    for (size_t i = 0; i < sprite_list.size(); i++) {
-        for (size_t j = 0; j < sprite_list[i].images.size(); j++) {
-            //Write texture ID
-            WriteU16(file, sprite_list[i].images[j].texture_id);
-            //Write number of palettes
-            WriteU16(file, sprite_list[i].images[j].num_palettes);
-            //Write image position
-            WriteS16(file, sprite_list[i].images[j].x);
-            WriteS16(file, sprite_list[i].images[j].y);
-            //Write source position
-            WriteU16(file, sprite_list[i].images[j].src_x);
-            WriteU16(file, sprite_list[i].images[j].src_y);
-            //Write image size
-            WriteU16(file, sprite_list[i].images[j].w);
-            WriteU16(file, sprite_list[i].images[j].h);
-            WriteU8(file, 0); //Unknown field 1
-            //Write alpha mode
-            WriteU8(file, sprite_list[i].images[j].alpha_mode);
-            WriteU8(file, 0); //Unknown field 2
-            WriteU8(file, 0); //Unknown field 3
-            //Write angle
-            WriteS16(file, sprite_list[i].images[j].angle);
-            //Write blend mode
-            WriteU8(file, sprite_list[i].images[j].blend_mode);
-            //Write bilinear flag
-            WriteBool(file, sprite_list[i].images[j].bilinear);
-            //Write flip flags
-            WriteU8(file, sprite_list[i].images[j].flip);
-            WriteU8(file, 255); //Alpha field (always 255)
-            WriteU16(file, 0); //Unknown field 4
+    if (list_ec) {
+        AddMirrorResult(state, dir.u8string(), "Failed to list directory. " + list_ec.message());
+    }
+    //Directories come first so the walk finds large files before workers run out of smaller ones
+    for (size_t i = 0; i < sub_dirs.size(); i++) {
+        std::filesystem::path sub_dir = sub_dirs[i];
+        SubmitTask(state.scheduler, UINT64_MAX, [&state, sub_dir]() {
+            WalkMirrorDirectory(state, sub_dir);
+        });
+    }
+    //Inputs sharing an output are always in same directory, sort so same one wins every run
+    std::sort(files.begin(), files.end());
+    std::unordered_set<std::string> out_paths;
+    for (size_t i = 0; i < files.size(); i++) {
+        //Mirror relative path of input into output directory
+        std::filesystem::path out_path = state.out_root / files[i].first.lexically_relative(state.in_root);
+        out_path.replace_extension(GetOutputExtension(state.mode, files[i].first.u8string()));
+        MirrorResult &result = AddMirrorResult(state, files[i].first.u8string(), "");
+        if (!out_paths.insert(out_path.u8string()).second) {
+            //Source files with same name in different formats build same output
+            result.error = "Output " + out_path.u8string() + " is already converted from another input.";
+            continue;
         }
+        //Largest files run first so one large file does not finish last on its own
+        SubmitTask(state.scheduler, files[i].second, [&state, &result, out_path]() {
+            ConvertMirrorFile(state, result, out_path);
+        });
     }
 }
 
-void VerifyFrameSpriteNames()
+int RunMirror(const ToolOptions &options, ToolMode mode, std::vector<std::string> dirs)
 {
-    //Loop over all animation frames
-    for (size_t i = 0; i < anim_list.size(); i++) {
-        for (size_t j = 0; j < anim_list[i].size(); j++) {
-            uint16_t sprite_idx;
-            if (!FindSprite(anim_list[i][j].sprite_name, &sprite_idx)) {
-                //Terminate if sprite name is not found
-                std::cout << "Sprite name " << anim_list[i][j].sprite_name << " not found." << std::endl;
-                exit(1);
-            }
+    if (dirs.size() != 2) {
+        std::cout << "-mirror requires an input and output directory." << std::endl;
+        return 1;
+    }
+    MirrorState state;
+    state.options = &options;
+    state.mode = mode;
+    state.in_root = std::filesystem::u8path(dirs[0]);
+    state.out_root = std::filesystem::u8path(dirs[1]);
+    //Builds and conversions take XML, JSON, and sprite project files
+    if (mode == MODE_DUMP) {
+        state.in_extensions.push_back(".spr");
+    } else {
+        state.in_extensions.push_back(".xml");
+        state.in_extensions.push_back(".json");
+        state.in_extensions.push_back(".sprj");
+    }
+    std::error_code ec;
+    if (!std::filesystem::is_directory(state.in_root, ec)) {
+        std::cout << "Input directory " << dirs[0] << " not found." << std::endl;
+        return 1;
+    }
+    //Workers list directories and convert files found so far at same time
+    StartScheduler(state.scheduler, options.num_threads);
+    SubmitTask(state.scheduler, UINT64_MAX, [&state]() {
+        WalkMirrorDirectory(state, state.in_root);
+    });
+    StopScheduler(state.scheduler);
+    const std::deque<MirrorResult> &results = state.results;
+    //Walk order depends on file system so report problems sorted by name
+    std::vector<const MirrorResult *> sorted_results;
+    size_t num_failed = 0;
+    size_t num_cached = 0;
+    ConversionStats total_stats = {};
+    for (size_t i = 0; i < results.size(); i++) {
+        AddConversionStats(total_stats, results[i].stats);
+        if (!results[i].success || !results[i].warnings.empty()) {
+            sorted_results.push_back(&results[i]);
+        }
+        if (!results[i].success) {
+            num_failed++;
+        }
+        if (results[i].cache_hit) {
+            num_cached++;
         }
     }
-}
-
-void BuildSprite(std::string in_file, std::string out_file)
-{
-    //Read XML File
-    tinyxml2::XMLDocument document;
-    XMLCheck(document.LoadFile(in_file.c_str()));
-    //Get root element
-    tinyxml2::XMLElement *root = document.FirstChildElement("spritedata");
-    if (!root) {
-        //Terminate if root element is not found
-        std::cout << "No root element found." << std::endl;
-        exit(1);
-    }
-    //Parse sprite data
-    ParseSprites(document, root);
-    ParseAnims(document, root);
-    VerifyFrameSpriteNames(); //Check data
-    //Try to open output file
-    FILE *file = fopen(out_file.c_str(), "wb");
-    if (!file) {
-        std::cout << "Failed to open " << out_file << " for writing." << std::endl;
-        exit(1);
-    }
-    CalcSpriteBoundingRects(); //Get bounding rectangles for sprites
-    //Create sprite header to write
-    SpriteHeader header;
-    CreateSpriteHeader(header);
-    WriteSpriteHeader(file, header);
-    //Write file sections
-    WriteSprites(file);
-    WriteAnims(file);
-    WriteAnimFrames(file);
-    WriteImages(file);
-    //End file write
-    fclose(file);
+    std::sort(sorted_results.begin(), sorted_results.end(), [](const MirrorResult *a, const MirrorResult *b) {
+        return a->in_file < b->in_file;
+    });
+    for (size_t i = 0; i < sorted_results.size(); i++) {
+        PrintWarnings(sorted_results[i]->in_file + ": ", sorted_results[i]->warnings);
+        if (!sorted_results[i]->success) {
+            std::cout << sorted_results[i]->in_file << ": " << sorted_results[i]->error << std::endl;
+        }
+    }
+    PrintSummary(results.size() - num_failed, results.size(), num_cached, options);
+    if (!WriteReports(options, total_stats)) {
+        return 1;
+    }
+    return (num_failed == 0) ? 0 : 1;
 }
 
 int main(int argc, char **argv)
 {
-    if (argc != 3 && argc != 4) {
+    //Get parameters to program
+    std::vector<std::string> args(argv + 1, argv + argc);
+    ToolOptions options;
+    if (!ParseOptions(args, options)) {
+        return 1;
+    }
+    std::string mode = (args.size() >= 2) ? args[1] : "";
+    if (args.size() < 2 || (args.size() > 3 && mode != "-batch" && mode != "-mirror")) {
         //Write usage statement
-        std::cout << "Usage: " << argv[0] << " {-d|-b} in [out]" << std::endl;
-        std::cout << "-d dumps the input sprite file into an XML file" << std::endl;
-        std::cout << "-b builds a sprite file from the input XML file" << std::endl;
+        std::cout << "Usage: " << argv[0] << " {-d|-b|-c} [options] in [out]" << std::endl;
+        std::cout << "       " << argv[0] << " {-d|-b|-c} [options] -batch in..." << std::endl;
+        std::cout << "       " << argv[0] << " {-d|-b|-c} [options] -mirror in_dir out_dir" << std::endl;
+        std::cout << "-d dumps the input sprite file into an XML file, or a JSON or sprite project file if out ends in .json or .sprj" << std::endl;
+        std::cout << "-b builds a sprite file from the input XML, JSON, or sprite project file" << std::endl;
+        std::cout << "-c converts the input XML or JSON file to a sprite project file or the input sprite project file to XML" << std::endl;
+        std::cout << "   Naming out with .xml, .json, or .sprj converts to that format instead." << std::endl;
         std::cout << "A derived name will be used for out if not provided." << std::endl;
+        std::cout << "-batch converts every input to a derived name on multiple threads." << std::endl;
+        std::cout << "Batch inputs may be file names, wildcard patterns, or @files listing inputs." << std::endl;
+        std::cout << "-mirror converts every input file under in_dir into the same path under out_dir." << std::endl;
+        std::cout << "Options:" << std::endl;
+        std::cout << "-j threads sets the number of threads used by -batch and -mirror or to build one large XML file" << std::endl;
+        std::cout << "-cache dir reuses sprite files previously built from identical input files" << std::endl;
+        std::cout << "-stats prints time spent in each phase and amount of data converted" << std::endl;
+        std::cout << "-stats-json file writes the same statistics to file as JSON" << std::endl;
+        std::cout << "-perf-counters adds cycles, instructions, cache misses, and branch misses to statistics on Linux" << std::endl;
+        std::cout << "-mem-report adds heap allocations, bytes allocated, and peak heap and resident memory to statistics" << std::endl;
+        std::cout << "-trace file writes when each file and phase ran on each thread for chrome://tracing or Perfetto" << std::endl;
         return 1;
     }
-    //Get parameters to program
-    std::string option = argv[1];
-    std::string in_file = argv[2];
-    std::string out_file = "";
-    //Use fourth argument for output name if present
-    if (argc == 4) {
-        out_file = argv[3];
+    std::string option = args[0];
+    if (option != "-d" && option != "-b" && option != "-c") {
+        //Warn about invalid option
+        std::cout << "Invalid option " << option << "." << std::endl;
+        return 1;
     }
+    ToolMode tool_mode = MODE_CONVERT;
     if (option == "-d") {
-        //Generate derived name for sprite dump
-        if (out_file == "") {
-            std::string out_name = in_file.substr(0, in_file.find_last_of('.'));
-            out_file = out_name + ".xml";
-        }
-        DumpSprite(in_file, out_file);
+        tool_mode = MODE_DUMP;
     } else if (option == "-b") {
-        //Generate derived name for sprite build
-        if (out_file == "") {
-            std::string out_name = in_file.substr(0, in_file.find_last_of('.'));
-            out_file = out_name + ".spr";
-        }
-        BuildSprite(in_file, out_file);
-    } else {
-        //Warn about invalid option
-        std::cout << "Invalid option " << option << "." << std::endl;
+        tool_mode = MODE_BUILD;
+    }
+    TraceRecorder trace;
+    if (!options.trace_file.empty()) {
+        //Record from here so trace shows time spent finding inputs
+        InitTraceRecorder(trace);
+        options.trace = &trace;
+    }
+    if (mode == "-batch") {
+        return RunBatch(options, tool_mode, std::vector<std::string>(args.begin() + 2, args.end()));
+    }
+    if (mode == "-mirror") {
+        return RunMirror(options, tool_mode, std::vector<std::string>(args.begin() + 2, args.end()));
+    }
+    std::string in_file = args[1];
+    std::string out_file = "";
+    //Use third argument for output name if present
+    if (args.size() == 3) {
+        out_file = args[2];
+    }
+    //Generate derived name for output
+    if (out_file == "") {
+        out_file = GetDerivedName(in_file, GetOutputExtension(tool_mode, in_file));
+    }
+    ConversionContext context;
+    context.num_threads = options.num_threads; //Only one file to spread threads over
+    bool success = ConvertFile(context, options, tool_mode, in_file, out_file);
+    PrintWarnings("", context.warnings);
+    if (!success) {
+        std::cout << context.error << std::endl;
+    }
+    if (!WriteReports(options, context.stats) || !success) {
         return 1;
     }
     //Program successful
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,319 @@
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <charconv>
+#include <cmath>
+#include <vector>
+#include "xmlreader.h"
+#include "json.h"
+
+void InitJSONReader(JSONReader &reader, const char *data, size_t size)
+{
+    reader.start = data;
+    reader.pos = data;
+    reader.end = data + size;
+    //Skip UTF-8 byte order mark
+    if (size >= 3 && memcmp(data, "\xEF\xBB\xBF", 3) == 0) {
+        reader.pos += 3;
+    }
+    reader.decoded_string.clear();
+    reader.decoded_key.clear();
+    reader.error.clear();
+}
+
+size_t GetJSONLine(const JSONReader &reader)
+{
+    size_t line = 1;
+    for (const char *c = reader.start; c < reader.pos; c++) {
+        if (*c == '\n') {
+            line++;
+        }
+    }
+    return line;
+}
+
+bool SetJSONError(JSONReader &reader, std::string error)
+{
+    reader.error = "Line " + std::to_string(GetJSONLine(reader)) + ": " + error;
+    return false;
+}
+
+void SkipJSONSpace(JSONReader &reader)
+{
+    while (reader.pos < reader.end && (*reader.pos == ' ' || *reader.pos == '\t' || *reader.pos == '\r' || *reader.pos == '\n')) {
+        reader.pos++;
+    }
+}
+
+bool ReadJSONHex4(JSONReader &reader, uint32_t &code)
+{
+    if (reader.end - reader.pos < 4) {
+        return false;
+    }
+    std::from_chars_result result = std::from_chars(reader.pos, reader.pos + 4, code, 16);
+    if (result.ec != std::errc() || result.ptr != reader.pos + 4) {
+        return false;
+    }
+    reader.pos += 4;
+    return true;
+}
+
+bool ReadJSONString(JSONReader &reader, std::string_view &text, std::string &storage)
+{
+    //Skip opening quote
+    reader.pos++;
+    const char *string_start = reader.pos;
+    while (reader.pos < reader.end && *reader.pos != '"' && *reader.pos != '\\') {
+        if ((uint8_t)*reader.pos < 0x20) {
+            return SetJSONError(reader, "Control character in string.");
+        }
+        reader.pos++;
+    }
+    if (reader.pos < reader.end && *reader.pos == '"') {
+        //Strings without escapes are used in place
+        text = std::string_view(string_start, reader.pos - string_start);
+        reader.pos++;
+        return true;
+    }
+    storage.assign(string_start, reader.pos - string_start);
+    while (reader.pos < reader.end && *reader.pos != '"') {
+        char c = *reader.pos++;
+        if ((uint8_t)c < 0x20) {
+            return SetJSONError(reader, "Control character in string.");
+        }
+        if (c != '\\') {
+            storage += c;
+            continue;
+        }
+        if (reader.pos >= reader.end) {
+            break;
+        }
+        //Decode escape sequence
+        const char *escapes = "\"\\/bfnrt";
+        const char *values = "\"\\/\b\f\n\r\t";
+        c = *reader.pos++;
+        const char *escape = strchr(escapes, c);
+        if (c != '\0' && escape) {
+            storage += values[escape - escapes];
+            continue;
+        }
+        uint32_t code;
+        if (c != 'u' || !ReadJSONHex4(reader, code)) {
+            return SetJSONError(reader, "Invalid escape in string.");
+        }
+        if (code >= 0xD800 && code < 0xDC00) {
+            //Combine surrogate pair
+            uint32_t low;
+            if (reader.end - reader.pos < 2 || reader.pos[0] != '\\' || reader.pos[1] != 'u') {
+                return SetJSONError(reader, "Unpaired surrogate in string.");
+            }
+            reader.pos += 2;
+            if (!ReadJSONHex4(reader, low) || low < 0xDC00 || low >= 0xE000) {
+                return SetJSONError(reader, "Unpaired surrogate in string.");
+            }
+            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+        } else if (code >= 0xDC00 && code < 0xE000) {
+            return SetJSONError(reader, "Unpaired surrogate in string.");
+        }
+        AppendUTF8(storage, code);
+    }
+    if (reader.pos >= reader.end) {
+        return SetJSONError(reader, "Unterminated string.");
+    }
+    reader.pos++;
+    text = storage;
+    return true;
+}
+
+JSONValueType ReadJSONValue(JSONReader &reader, std::string_view &text)
+{
+    SkipJSONSpace(reader);
+    if (reader.pos >= reader.end) {
+        SetJSONError(reader, "Unexpected end of document.");
+        return JSON_VALUE_ERROR;
+    }
+    if (*reader.pos == '{') {
+        reader.pos++;
+        return JSON_VALUE_OBJECT;
+    }
+    if (*reader.pos == '[') {
+        reader.pos++;
+        return JSON_VALUE_ARRAY;
+    }
+    if (*reader.pos == '"') {
+        if (!ReadJSONString(reader, text, reader.decoded_string)) {
+            return JSON_VALUE_ERROR;
+        }
+        return JSON_VALUE_STRING;
+    }
+    //Read number or keyword, leaving validation to whoever uses it
+    const char *literal_start = reader.pos;
+    while (reader.pos < reader.end && (isalnum((uint8_t)*reader.pos) || *reader.pos == '-' || *reader.pos == '+' || *reader.pos == '.')) {
+        reader.pos++;
+    }
+    if (reader.pos == literal_start) {
+        SetJSONError(reader, std::string("Unexpected character ") + *reader.pos + ".");
+        return JSON_VALUE_ERROR;
+    }
+    text = std::string_view(literal_start, reader.pos - literal_start);
+    return JSON_VALUE_LITERAL;
+}
+
+bool ReadJSONSeparator(JSONReader &reader, char end, bool first)
+{
+    SkipJSONSpace(reader);
+    if (reader.pos < reader.end && *reader.pos == end) {
+        //Container ended
+        reader.pos++;
+        return false;
+    }
+    if (!first) {
+        if (reader.pos >= reader.end || *reader.pos != ',') {
+            return SetJSONError(reader, std::string("Expected , or ") + end + ".");
+        }
+        reader.pos++;
+        SkipJSONSpace(reader);
+    }
+    return true;
+}
+
+bool ReadJSONKey(JSONReader &reader, std::string_view &key, bool first)
+{
+    if (!ReadJSONSeparator(reader, '}', first)) {
+        return false;
+    }
+    if (reader.pos >= reader.end || *reader.pos != '"') {
+        return SetJSONError(reader, "Expected object key.");
+    }
+    if (!ReadJSONString(reader, key, reader.decoded_key)) {
+        return false;
+    }
+    SkipJSONSpace(reader);
+    if (reader.pos >= reader.end || *reader.pos != ':') {
+        return SetJSONError(reader, "Expected : after key " + std::string(key) + ".");
+    }
+    reader.pos++;
+    return true;
+}
+
+bool NextJSONItem(JSONReader &reader, bool first)
+{
+    return ReadJSONSeparator(reader, ']', first);
+}
+
+bool SkipJSONValue(JSONReader &reader, JSONValueType type)
+{
+    //Track open containers without recursion so deep nesting is safe
+    std::vector<JSONValueType> open_values;
+    std::vector<bool> first_items;
+    if (type == JSON_VALUE_OBJECT || type == JSON_VALUE_ARRAY) {
+        open_values.push_back(type);
+        first_items.push_back(true);
+    }
+    while (!open_values.empty()) {
+        bool first = first_items.back();
+        first_items.back() = false;
+        bool has_item;
+        if (open_values.back() == JSON_VALUE_OBJECT) {
+            std::string_view key;
+            has_item = ReadJSONKey(reader, key, first);
+        } else {
+            has_item = NextJSONItem(reader, first);
+        }
+        if (!has_item) {
+            if (!reader.error.empty()) {
+                return false;
+            }
+            open_values.pop_back();
+            first_items.pop_back();
+            continue;
+        }
+        std::string_view text;
+        JSONValueType item_type = ReadJSONValue(reader, text);
+        if (item_type == JSON_VALUE_ERROR) {
+            return false;
+        }
+        if (item_type == JSON_VALUE_OBJECT || item_type == JSON_VALUE_ARRAY) {
+            open_values.push_back(item_type);
+            first_items.push_back(true);
+        }
+    }
+    return true;
+}
+
+bool FinishJSONReader(JSONReader &reader)
+{
+    SkipJSONSpace(reader);
+    if (reader.pos != reader.end) {
+        return SetJSONError(reader, "Unexpected text after root value.");
+    }
+    return true;
+}
+
+void WriteJSONString(std::string &out, std::string_view text)
+{
+    out += '"';
+    for (size_t i = 0; i < text.size(); i++) {
+        char c = text[i];
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (c == '\n') {
+            out += "\\n";
+        } else if (c == '\r') {
+            out += "\\r";
+        } else if (c == '\t') {
+            out += "\\t";
+        } else if ((uint8_t)c < 0x20) {
+            //Escape control characters by code
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", (unsigned)c);
+            out += buf;
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+void WriteJSONKey(std::string &out, const char *key)
+{
+    WriteJSONString(out, key);
+    out += ": ";
+}
+
+void WriteJSONInt(std::string &out, int32_t value)
+{
+    char buf[16];
+    out.append(buf, std::to_chars(buf, buf + sizeof(buf), value).ptr);
+}
+
+void WriteJSONUnsigned(std::string &out, uint64_t value)
+{
+    char buf[24];
+    out.append(buf, std::to_chars(buf, buf + sizeof(buf), value).ptr);
+}
+
+void WriteJSONFloat(std::string &out, float value)
+{
+    char buf[32];
+    char *end = std::to_chars(buf, buf + sizeof(buf), value).ptr;
+    if (!std::isfinite(value)) {
+        //JSON numbers cannot be infinite or NaN
+        WriteJSONString(out, std::string_view(buf, end - buf));
+        return;
+    }
+    out.append(buf, end);
+}
+
+void WriteJSONDouble(std::string &out, double value)
+{
+    char buf[32];
+    char *end = std::to_chars(buf, buf + sizeof(buf), value).ptr;
+    if (!std::isfinite(value)) {
+        WriteJSONString(out, std::string_view(buf, end - buf));
+        return;
+    }
+    out.append(buf, end);
+}
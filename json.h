@@ -0,0 +1,51 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+
+enum JSONValueType {
+    JSON_VALUE_OBJECT,
+    JSON_VALUE_ARRAY,
+    JSON_VALUE_STRING,
+    JSON_VALUE_LITERAL, //Number, true, false, or null
+    JSON_VALUE_ERROR
+};
+
+struct JSONReader {
+    const char *start;
+    const char *pos;
+    const char *end;
+    std::string decoded_string; //Storage for string values containing escapes
+    std::string decoded_key; //Storage for keys containing escapes
+    std::string error;
+};
+
+//Starts reading JSON text without copying it
+void InitJSONReader(JSONReader &reader, const char *data, size_t size);
+//Reads start of next value, consuming scalars and only the opening bracket of containers
+JSONValueType ReadJSONValue(JSONReader &reader, std::string_view &text);
+//Reads next key of object that just started, returning false at end of object or on error
+bool ReadJSONKey(JSONReader &reader, std::string_view &key, bool first);
+//Moves to next item of array that just started, returning false at end of array or on error
+bool NextJSONItem(JSONReader &reader, bool first);
+//Skips rest of value whose start was just read
+bool SkipJSONValue(JSONReader &reader, JSONValueType type);
+//Checks that only whitespace follows the root value
+bool FinishJSONReader(JSONReader &reader);
+//Line number of current reader position
+size_t GetJSONLine(const JSONReader &reader);
+
+//Appends text as a quoted JSON string
+void WriteJSONString(std::string &out, std::string_view text);
+//Appends quoted key followed by a colon
+void WriteJSONKey(std::string &out, const char *key);
+void WriteJSONInt(std::string &out, int32_t value);
+void WriteJSONUnsigned(std::string &out, uint64_t value);
+//Appends shortest round-trip float, using strings for values JSON numbers cannot hold
+void WriteJSONFloat(std::string &out, float value);
+void WriteJSONDouble(std::string &out, double value);
+
+#endif
@@ -0,0 +1,133 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <atomic>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#include <sys/resource.h>
+#else
+#include <malloc.h>
+#include <sys/resource.h>
+#endif
+#include "memtrack.h"
+
+std::atomic<bool> allocation_tracking(false);
+std::atomic<uint64_t> process_allocs(0);
+std::atomic<uint64_t> process_bytes(0);
+std::atomic<int64_t> process_live_bytes(0);
+std::atomic<int64_t> process_peak_live_bytes(0);
+//Plain data so operator new can use it while threads start and exit
+thread_local AllocationCounts thread_counts = { 0, 0, 0, 0 };
+
+void EnableAllocationTracking()
+{
+    allocation_tracking.store(true, std::memory_order_relaxed);
+}
+
+bool IsAllocationTrackingEnabled()
+{
+    return allocation_tracking.load(std::memory_order_relaxed);
+}
+
+void RaisePeakLiveBytes(std::atomic<int64_t> &peak, int64_t live_bytes)
+{
+    int64_t old_peak = peak.load(std::memory_order_relaxed);
+    while (live_bytes > old_peak && !peak.compare_exchange_weak(old_peak, live_bytes, std::memory_order_relaxed)) {
+    }
+}
+
+void CountAllocation(size_t size)
+{
+    if (!allocation_tracking.load(std::memory_order_relaxed)) {
+        return;
+    }
+    thread_counts.allocs++;
+    thread_counts.bytes += size;
+    thread_counts.live_bytes += size;
+    if (thread_counts.live_bytes > thread_counts.peak_live_bytes) {
+        thread_counts.peak_live_bytes = thread_counts.live_bytes;
+    }
+    process_allocs.fetch_add(1, std::memory_order_relaxed);
+    process_bytes.fetch_add(size, std::memory_order_relaxed);
+    int64_t live_bytes = process_live_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+    RaisePeakLiveBytes(process_peak_live_bytes, live_bytes);
+}
+
+void CountFree(size_t size)
+{
+    if (!allocation_tracking.load(std::memory_order_relaxed)) {
+        return;
+    }
+    //Blocks freed by another thread than allocated them leave thread counts skewed,
+    //which only matters for phases spread over threads and those use process counts
+    thread_counts.live_bytes -= size;
+    process_live_bytes.fetch_sub(size, std::memory_order_relaxed);
+}
+
+size_t GetAllocationSize(void *ptr)
+{
+#ifdef _WIN32
+    return _msize(ptr);
+#elif defined(__APPLE__)
+    return malloc_size(ptr);
+#else
+    return malloc_usable_size(ptr);
+#endif
+}
+
+void ReadAllocationCounts(AllocationCounts &counts, bool whole_process)
+{
+    if (whole_process) {
+        counts.allocs = process_allocs.load(std::memory_order_relaxed);
+        counts.bytes = process_bytes.load(std::memory_order_relaxed);
+        counts.live_bytes = process_live_bytes.load(std::memory_order_relaxed);
+        counts.peak_live_bytes = process_peak_live_bytes.load(std::memory_order_relaxed);
+    } else {
+        counts = thread_counts;
+    }
+}
+
+int64_t ResetPeakLiveBytes(bool whole_process)
+{
+    if (whole_process) {
+        return process_peak_live_bytes.exchange(process_live_bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    int64_t peak = thread_counts.peak_live_bytes;
+    thread_counts.peak_live_bytes = thread_counts.live_bytes;
+    return peak;
+}
+
+void RestorePeakLiveBytes(int64_t peak, bool whole_process)
+{
+    if (whole_process) {
+        RaisePeakLiveBytes(process_peak_live_bytes, peak);
+    } else if (peak > thread_counts.peak_live_bytes) {
+        thread_counts.peak_live_bytes = peak;
+    }
+}
+
+uint64_t GetPeakResidentBytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return counters.PeakWorkingSetSize;
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    return usage.ru_maxrss; //Already in bytes
+#else
+    return (uint64_t)usage.ru_maxrss * 1024;
+#endif
+#endif
+}
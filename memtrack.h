@@ -0,0 +1,31 @@
+#ifndef MEMTRACK_H
+#define MEMTRACK_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+struct AllocationCounts {
+    uint64_t allocs;
+    uint64_t bytes; //Heap bytes handed out including allocator rounding
+    int64_t live_bytes; //Allocated minus freed, may start below zero for blocks from before tracking
+    int64_t peak_live_bytes; //Highest live_bytes since last ResetPeakLiveBytes
+};
+
+//Starts counting allocations reported by CountAllocation and CountFree
+void EnableAllocationTracking();
+//Lets operator new and delete skip looking up block sizes while tracking is off
+bool IsAllocationTrackingEnabled();
+//Called by the program's operator new and delete with the heap size of each block
+void CountAllocation(size_t size);
+void CountFree(size_t size);
+//Heap size of block from malloc
+size_t GetAllocationSize(void *ptr);
+//Reads counts of calling thread or the whole process
+void ReadAllocationCounts(AllocationCounts &counts, bool whole_process);
+//Restarts peak from current live bytes, returning old peak so nested scopes can restore it
+int64_t ResetPeakLiveBytes(bool whole_process);
+void RestorePeakLiveBytes(int64_t peak, bool whole_process);
+//Highest resident set size of the process so far, 0 if unknown
+uint64_t GetPeakResidentBytes();
+
+#endif
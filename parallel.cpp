@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "parallel.h"
+
+unsigned GetDefaultThreadCount()
+{
+    unsigned num_threads = std::thread::hardware_concurrency();
+    //Hardware concurrency is 0 when it cannot be determined
+    if (num_threads == 0) {
+        return 1;
+    }
+    return num_threads;
+}
+
+void ParallelFor(size_t count, unsigned num_threads, const std::function<void(size_t)> &func)
+{
+    if (num_threads > count) {
+        //Never start threads without work
+        num_threads = count;
+    }
+    if (num_threads <= 1) {
+        //Run on calling thread
+        for (size_t i = 0; i < count; i++) {
+            func(i);
+        }
+        return;
+    }
+    std::atomic<size_t> next_idx(0);
+    auto worker = [&]() {
+        //Claim indices until all are taken
+        size_t idx;
+        while ((idx = next_idx.fetch_add(1)) < count) {
+            func(idx);
+        }
+    };
+    //Calling thread is one of the workers
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < num_threads; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+}
+
+//Worker the current thread runs for, if any
+thread_local TaskScheduler *current_scheduler = nullptr;
+thread_local size_t current_worker = 0;
+
+bool CompareTaskPriority(const Task &a, const Task &b)
+{
+    return a.priority < b.priority;
+}
+
+bool TakeTask(TaskQueue &queue, Task &task)
+{
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    std::pop_heap(queue.tasks.begin(), queue.tasks.end(), CompareTaskPriority);
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool PopTask(TaskScheduler &scheduler, size_t worker, Task &task)
+{
+    //Take from own queue first
+    if (TakeTask(*scheduler.queues[worker], task)) {
+        return true;
+    }
+    //Steal highest priority task of other queues so large work is not left to the end
+    for (size_t i = 1; i < scheduler.queues.size(); i++) {
+        if (TakeTask(*scheduler.queues[(worker + i) % scheduler.queues.size()], task)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void RunWorker(TaskScheduler &scheduler, size_t worker)
+{
+    current_scheduler = &scheduler;
+    current_worker = worker;
+    while (true) {
+        Task task;
+        if (PopTask(scheduler, worker, task)) {
+            {
+                std::lock_guard<std::mutex> lock(scheduler.state_mutex);
+                scheduler.num_queued--;
+            }
+            task.func();
+            //Wake waiters once last task finishes
+            std::lock_guard<std::mutex> lock(scheduler.state_mutex);
+            if (--scheduler.num_pending == 0) {
+                scheduler.work_done.notify_all();
+            }
+            continue;
+        }
+        //Sleep until a task is queued
+        std::unique_lock<std::mutex> lock(scheduler.state_mutex);
+        scheduler.work_available.wait(lock, [&]() {
+            return scheduler.num_queued != 0 || scheduler.stopping;
+        });
+        if (scheduler.num_queued == 0 && scheduler.stopping) {
+            break;
+        }
+    }
+    current_scheduler = nullptr;
+}
+
+void StartScheduler(TaskScheduler &scheduler, unsigned num_threads)
+{
+    if (num_threads == 0) {
+        num_threads = 1;
+    }
+    scheduler.num_queued = 0;
+    scheduler.num_pending = 0;
+    scheduler.next_queue = 0;
+    scheduler.stopping = false;
+    for (unsigned i = 0; i < num_threads; i++) {
+        scheduler.queues.emplace_back(new TaskQueue);
+    }
+    for (unsigned i = 0; i < num_threads; i++) {
+        scheduler.threads.emplace_back(RunWorker, std::ref(scheduler), i);
+    }
+}
+
+void SubmitTask(TaskScheduler &scheduler, uint64_t priority, std::function<void()> func)
+{
+    size_t queue_idx;
+    {
+        //Count task before queueing so it cannot finish before being counted
+        std::lock_guard<std::mutex> lock(scheduler.state_mutex);
+        scheduler.num_queued++;
+        scheduler.num_pending++;
+        if (current_scheduler == &scheduler) {
+            //Tasks queued from workers stay local until stolen
+            queue_idx = current_worker;
+        } else {
+            //Spread outside tasks over workers
+            queue_idx = scheduler.next_queue++ % scheduler.queues.size();
+        }
+    }
+    {
+        TaskQueue &queue = *scheduler.queues[queue_idx];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(Task { priority, std::move(func) });
+        std::push_heap(queue.tasks.begin(), queue.tasks.end(), CompareTaskPriority);
+    }
+    std::lock_guard<std::mutex> lock(scheduler.state_mutex);
+    scheduler.work_available.notify_one();
+}
+
+void WaitForTasks(TaskScheduler &scheduler)
+{
+    std::unique_lock<std::mutex> lock(scheduler.state_mutex);
+    scheduler.work_done.wait(lock, [&]() {
+        return scheduler.num_pending == 0;
+    });
+}
+
+void StopScheduler(TaskScheduler &scheduler)
+{
+    WaitForTasks(scheduler);
+    {
+        std::lock_guard<std::mutex> lock(scheduler.state_mutex);
+        scheduler.stopping = true;
+        scheduler.work_available.notify_all();
+    }
+    for (size_t i = 0; i < scheduler.threads.size(); i++) {
+        scheduler.threads[i].join();
+    }
+    scheduler.threads.clear();
+    scheduler.queues.clear();
+}
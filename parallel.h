@@ -0,0 +1,49 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+struct Task {
+    uint64_t priority; //Higher priority tasks run first
+    std::function<void()> func;
+};
+
+struct TaskQueue {
+    std::mutex mutex;
+    std::vector<Task> tasks; //Heap with highest priority task at front, taken by owner and thieves alike
+};
+
+struct TaskScheduler {
+    std::vector<std::unique_ptr<TaskQueue>> queues; //One queue per worker
+    std::vector<std::thread> threads;
+    std::mutex state_mutex; //Guards counters below
+    std::condition_variable work_available;
+    std::condition_variable work_done;
+    size_t num_queued; //Tasks waiting in any queue
+    size_t num_pending; //Tasks submitted but not finished
+    size_t next_queue; //Queue for next task submitted from outside of workers
+    bool stopping;
+};
+
+//Number of threads to use when none is requested
+unsigned GetDefaultThreadCount();
+//Calls func for every index below count on up to num_threads threads
+void ParallelFor(size_t count, unsigned num_threads, const std::function<void(size_t)> &func);
+
+//Starts num_threads workers which steal tasks from each other when idle
+void StartScheduler(TaskScheduler &scheduler, unsigned num_threads);
+//Queues task to run on a worker, may be called from tasks
+void SubmitTask(TaskScheduler &scheduler, uint64_t priority, std::function<void()> func);
+//Blocks until every submitted task has finished
+void WaitForTasks(TaskScheduler &scheduler);
+//Finishes remaining tasks and joins workers
+void StopScheduler(TaskScheduler &scheduler);
+
+#endif
@@ -0,0 +1,131 @@
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <mutex>
+#ifdef __linux__
+#include <errno.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+#include "perf.h"
+
+std::mutex perf_error_mutex;
+std::string perf_error;
+
+void SetPerfCounterError(std::string error)
+{
+    //Keep first reason since later threads fail the same way
+    std::lock_guard<std::mutex> lock(perf_error_mutex);
+    if (perf_error.empty()) {
+        perf_error = error;
+    }
+}
+
+std::string GetPerfCounterError()
+{
+    std::lock_guard<std::mutex> lock(perf_error_mutex);
+    return perf_error;
+}
+
+const char *GetPerfCounterName(PerfCounter counter)
+{
+    const char *names[PERF_COUNTER_COUNT] = { "cycles", "instructions", "cache_misses", "branch_misses" };
+    return names[counter];
+}
+
+#ifdef __linux__
+struct PerfCounterFiles {
+    int fds[PERF_COUNTER_COUNT];
+    bool opened;
+    bool failed;
+
+    PerfCounterFiles() : opened(false), failed(false)
+    {
+        for (size_t i = 0; i < PERF_COUNTER_COUNT; i++) {
+            fds[i] = -1;
+        }
+    }
+
+    ~PerfCounterFiles()
+    {
+        for (size_t i = 0; i < PERF_COUNTER_COUNT; i++) {
+            if (fds[i] >= 0) {
+                close(fds[i]);
+            }
+        }
+    }
+};
+
+bool OpenPerfCounters(PerfCounterFiles &files)
+{
+    const uint64_t configs[PERF_COUNTER_COUNT] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES
+    };
+    for (size_t i = 0; i < PERF_COUNTER_COUNT; i++) {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = configs[i];
+        attr.exclude_kernel = 1; //Allowed at the default paranoia level
+        attr.exclude_hv = 1;
+        //Worker threads started during a phase are joined before it ends so their counts are added in
+        attr.inherit = 1;
+        //Times let counts be scaled when counters are shared with other events
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        files.fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (files.fds[i] < 0) {
+            SetPerfCounterError(std::string("perf_event_open failed for ") + GetPerfCounterName((PerfCounter)i) + ": " + strerror(errno) + ".");
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ReadPerfCounter(int fd, uint64_t &value)
+{
+    uint64_t data[3]; //Value, time enabled, and time running
+    if (read(fd, data, sizeof(data)) != sizeof(data)) {
+        return false;
+    }
+    if (data[2] == 0) {
+        //Counter never got a turn on the hardware
+        value = 0;
+    } else if (data[2] < data[1]) {
+        //Estimate count for time the counter was not running
+        value = (uint64_t)((double)data[0] * data[1] / data[2]);
+    } else {
+        value = data[0];
+    }
+    return true;
+}
+#endif
+
+void ReadPerfCounters(PerfCounterValues &counters)
+{
+    counters.valid = false;
+#ifdef __linux__
+    //Counters only see the thread that opened them so every thread opens its own
+    thread_local PerfCounterFiles files;
+    if (!files.opened) {
+        files.opened = true;
+        files.failed = !OpenPerfCounters(files);
+    }
+    if (files.failed) {
+        return;
+    }
+    for (size_t i = 0; i < PERF_COUNTER_COUNT; i++) {
+        if (!ReadPerfCounter(files.fds[i], counters.values[i])) {
+            return;
+        }
+    }
+    counters.valid = true;
+#else
+    SetPerfCounterError("Hardware counters are only supported on Linux.");
+#endif
+}
@@ -0,0 +1,27 @@
+#ifndef PERF_H
+#define PERF_H
+
+#include <stdint.h>
+#include <string>
+
+enum PerfCounter {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_CACHE_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_COUNTER_COUNT
+};
+
+struct PerfCounterValues {
+    uint64_t values[PERF_COUNTER_COUNT];
+    bool valid; //False if counters could not be opened or read
+};
+
+//Reads hardware counters of calling thread and threads it starts later, opening them on first use
+void ReadPerfCounters(PerfCounterValues &counters);
+//Reason counters could not be opened, empty if they could
+std::string GetPerfCounterError();
+//Name of counter in reports
+const char *GetPerfCounterName(PerfCounter counter);
+
+#endif
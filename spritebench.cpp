@@ -0,0 +1,577 @@
+#define _CRT_SECURE_NO_WARNINGS //Shut up Visual Studio
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <filesystem>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sched.h>
+#endif
+#include "spritelib.h"
+#include "json.h"
+
+//Times conversions of sprite files in memory so results do not depend on disk speed
+
+enum BenchMode {
+    BENCH_DUMP, //Sprite file to XML
+    BENCH_BUILD, //XML to sprite file
+    BENCH_ROUND_TRIP, //Sprite file to XML and back
+    BENCH_COUNT
+};
+
+struct BenchOptions {
+    unsigned runs; //Timed runs of each benchmark
+    unsigned warmup_runs; //Untimed runs before timed ones
+    int cpu; //CPU to pin benchmark to, -1 to leave unpinned
+    unsigned num_threads; //Threads used to parse large XML files
+    bool modes[BENCH_COUNT]; //Benchmarks to run
+    std::string json_file; //File to write results to as JSON, empty to disable
+    std::string baseline_file; //Results JSON to compare throughput against, empty to disable
+    double threshold; //Percentage throughput may drop below baseline before failing
+};
+
+struct BenchFile {
+    std::string name;
+    std::vector<uint8_t> data; //Sprite file
+    std::string xml; //Dump of sprite file
+    uint64_t records; //Sprites, animations, frames, and images
+};
+
+struct BenchResult {
+    uint64_t bytes; //Input bytes of one run
+    uint64_t records; //Records of one run
+    std::vector<double> run_times; //Seconds
+    std::vector<double> phase_times[PHASE_COUNT]; //Seconds of each phase in each run
+    bool round_trip_mismatch; //Some round trip did not reproduce its input
+};
+
+const char *GetBenchName(BenchMode mode)
+{
+    const char *names[BENCH_COUNT] = { "dump", "build", "round_trip" };
+    return names[mode];
+}
+
+bool ParseBenchMode(std::string name, BenchMode &mode)
+{
+    for (size_t i = 0; i < BENCH_COUNT; i++) {
+        if (name == GetBenchName((BenchMode)i)) {
+            mode = (BenchMode)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ParseOptions(std::vector<std::string> &args, BenchOptions &options)
+{
+    options.runs = 10;
+    options.warmup_runs = 2;
+    options.cpu = -1;
+    options.num_threads = 1;
+    for (size_t i = 0; i < BENCH_COUNT; i++) {
+        options.modes[i] = true;
+    }
+    options.json_file = "";
+    options.baseline_file = "";
+    //Fastest runs of identical builds still differed by up to 12% on a shared machine
+    options.threshold = 15.0;
+    bool modes_chosen = false;
+    //Remove options and keep remaining arguments in order
+    std::vector<std::string> remaining;
+    for (size_t i = 0; i < args.size(); i++) {
+        if (args[i] == "-runs" && i + 1 < args.size()) {
+            options.runs = strtoul(args[++i].c_str(), nullptr, 10);
+            if (options.runs == 0) {
+                std::cout << "Invalid run count " << args[i] << "." << std::endl;
+                return false;
+            }
+        } else if (args[i] == "-warmup" && i + 1 < args.size()) {
+            options.warmup_runs = strtoul(args[++i].c_str(), nullptr, 10);
+        } else if (args[i] == "-cpu" && i + 1 < args.size()) {
+            options.cpu = atoi(args[++i].c_str());
+        } else if (args[i] == "-j" && i + 1 < args.size()) {
+            options.num_threads = strtoul(args[++i].c_str(), nullptr, 10);
+            if (options.num_threads == 0) {
+                std::cout << "Invalid thread count " << args[i] << "." << std::endl;
+                return false;
+            }
+        } else if (args[i] == "-mode" && i + 1 < args.size()) {
+            //First mode given replaces running every benchmark
+            BenchMode mode;
+            if (!ParseBenchMode(args[++i], mode)) {
+                std::cout << "Invalid benchmark " << args[i] << "." << std::endl;
+                return false;
+            }
+            if (!modes_chosen) {
+                for (size_t j = 0; j < BENCH_COUNT; j++) {
+                    options.modes[j] = false;
+                }
+                modes_chosen = true;
+            }
+            options.modes[mode] = true;
+        } else if (args[i] == "-json" && i + 1 < args.size()) {
+            options.json_file = args[++i];
+        } else if (args[i] == "-baseline" && i + 1 < args.size()) {
+            options.baseline_file = args[++i];
+        } else if (args[i] == "-threshold" && i + 1 < args.size()) {
+            options.threshold = strtod(args[++i].c_str(), nullptr);
+        } else {
+            remaining.push_back(args[i]);
+        }
+    }
+    args = remaining;
+    return true;
+}
+
+bool PinToCPU(int cpu)
+{
+    //Threads started later inherit the mask on Linux, but not on Windows
+#ifdef _WIN32
+    if (cpu >= (int)(sizeof(DWORD_PTR) * 8)) {
+        return false;
+    }
+    return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu) != 0;
+#else
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#endif
+}
+
+bool ReadWholeFile(std::string path, std::vector<uint8_t> &data)
+{
+    std::ifstream file(std::filesystem::u8path(path), std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return !file.bad();
+}
+
+void AddInputPaths(std::string input, std::vector<std::string> &paths)
+{
+    //Directories add every sprite file under them in sorted order so runs see the same corpus
+    std::filesystem::path path = std::filesystem::u8path(input);
+    std::error_code error_code;
+    if (!std::filesystem::is_directory(path, error_code)) {
+        paths.push_back(input);
+        return;
+    }
+    std::vector<std::string> dir_paths;
+    for (const auto &entry : std::filesystem::recursive_directory_iterator(path, error_code)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".spr") {
+            dir_paths.push_back(entry.path().u8string());
+        }
+    }
+    std::sort(dir_paths.begin(), dir_paths.end());
+    paths.insert(paths.end(), dir_paths.begin(), dir_paths.end());
+}
+
+bool LoadBenchFile(std::string path, BenchFile &file)
+{
+    file.name = path;
+    if (!ReadWholeFile(path, file.data)) {
+        std::cout << "Failed to read " << path << "." << std::endl;
+        return false;
+    }
+    //Dump up front so build runs start from XML
+    ConversionContext context;
+    if (!DecodeSprite(context, file.data.data(), file.data.size()) || !PrintSpriteXML(context, file.xml)) {
+        std::cout << "Failed to dump " << path << ". " << context.error << std::endl;
+        return false;
+    }
+    file.records = context.stats.sprites + context.stats.anims + context.stats.frames + context.stats.images;
+    return true;
+}
+
+bool RunConversion(BenchMode mode, const BenchFile &file, unsigned num_threads, ConversionContext &context, bool &mismatch)
+{
+    context.num_threads = num_threads;
+    std::string xml;
+    std::vector<uint8_t> buffer;
+    if (mode == BENCH_DUMP || mode == BENCH_ROUND_TRIP) {
+        //Same streaming printer as -d, with pieces kept in memory instead of written to disk
+        bool dumped = DumpSpriteData(context, file.data.data(), file.data.size(), SPRITE_FORMAT_XML, [&](const std::vector<std::string_view> &parts) {
+            for (size_t i = 0; i < parts.size(); i++) {
+                context.stats.bytes_out += parts[i].size();
+                if (mode == BENCH_ROUND_TRIP) {
+                    xml.append(parts[i].data(), parts[i].size());
+                }
+            }
+            return true;
+        });
+        if (!dumped) {
+            return false;
+        }
+        if (mode == BENCH_DUMP) {
+            return true;
+        }
+    }
+    const std::string &source = (mode == BENCH_BUILD) ? file.xml : xml;
+    if (!ParseSpriteXML(context, source.data(), source.size())) {
+        return false;
+    }
+    if (!EncodeSprite(context, buffer)) {
+        return false;
+    }
+    if (mode == BENCH_ROUND_TRIP && buffer != file.data) {
+        mismatch = true;
+    }
+    return true;
+}
+
+bool RunBenchmark(const BenchOptions &options, BenchMode mode, const std::vector<BenchFile> &files, BenchResult &result)
+{
+    result.bytes = 0;
+    result.records = 0;
+    for (size_t i = 0; i < files.size(); i++) {
+        result.bytes += (mode == BENCH_BUILD) ? files[i].xml.size() : files[i].data.size();
+        result.records += files[i].records;
+    }
+    result.round_trip_mismatch = false;
+    for (unsigned run = 0; run < options.warmup_runs + options.runs; run++) {
+        ConversionStats stats = {};
+        auto start_time = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < files.size(); i++) {
+            ConversionContext context;
+            if (!RunConversion(mode, files[i], options.num_threads, context, result.round_trip_mismatch)) {
+                std::cout << "Failed to run " << GetBenchName(mode) << " on " << files[i].name << ". " << context.error << std::endl;
+                return false;
+            }
+            AddConversionStats(stats, context.stats);
+        }
+        double run_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        //Warmup runs fill caches and grow the heap without being timed
+        if (run < options.warmup_runs) {
+            continue;
+        }
+        result.run_times.push_back(run_time);
+        for (size_t i = 0; i < PHASE_COUNT; i++) {
+            if (stats.phases[i].calls != 0) {
+                result.phase_times[i].push_back(stats.phases[i].wall_time);
+            }
+        }
+    }
+    return true;
+}
+
+double GetPercentile(std::vector<double> values, double percentile)
+{
+    //Nearest rank so every reported time was actually measured
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    size_t rank = (size_t)std::ceil(percentile / 100.0 * values.size());
+    return values[std::max<size_t>(rank, 1) - 1];
+}
+
+//Percentiles reported for run and phase times
+const double bench_percentiles[5] = { 0.0, 50.0, 90.0, 99.0, 100.0 };
+const char *bench_percentile_names[5] = { "min", "p50", "p90", "p99", "max" };
+
+double GetMBPerSecond(const BenchResult &result)
+{
+    double time = GetPercentile(result.run_times, 50.0);
+    return (time > 0.0) ? result.bytes / time / 1000000.0 : 0.0;
+}
+
+double GetPeakMBPerSecond(const BenchResult &result)
+{
+    //Fastest run is least disturbed by other processes so baselines compare it
+    double time = GetPercentile(result.run_times, 0.0);
+    return (time > 0.0) ? result.bytes / time / 1000000.0 : 0.0;
+}
+
+double GetRecordsPerSecond(const BenchResult &result)
+{
+    double time = GetPercentile(result.run_times, 50.0);
+    return (time > 0.0) ? result.records / time : 0.0;
+}
+
+void PrintTimeRow(std::string &text, const char *name, const std::vector<double> &times)
+{
+    char line[256];
+    snprintf(line, sizeof(line), "  %-14s", name);
+    text += line;
+    for (size_t i = 0; i < 5; i++) {
+        snprintf(line, sizeof(line), " %10.3f", GetPercentile(times, bench_percentiles[i]) * 1000.0);
+        text += line;
+    }
+    text += '\n';
+}
+
+void PrintResultText(BenchMode mode, const BenchResult &result, std::string &text)
+{
+    char line[256];
+    //Throughput comes from the median run
+    snprintf(line, sizeof(line), "%s: %.2f MB/s, %.0f records/s over %zu runs\n", GetBenchName(mode), GetMBPerSecond(result), GetRecordsPerSecond(result), result.run_times.size());
+    text += line;
+    snprintf(line, sizeof(line), "  %-14s %10s %10s %10s %10s %10s\n", "Time ms", "min", "p50", "p90", "p99", "max");
+    text += line;
+    PrintTimeRow(text, "total", result.run_times);
+    for (size_t i = 0; i < PHASE_COUNT; i++) {
+        if (!result.phase_times[i].empty()) {
+            PrintTimeRow(text, GetPhaseName((ConversionPhase)i), result.phase_times[i]);
+        }
+    }
+}
+
+void PrintPercentilesJSON(std::string &json, const std::vector<double> &times)
+{
+    json += '{';
+    for (size_t i = 0; i < 5; i++) {
+        if (i != 0) {
+            json += ", ";
+        }
+        WriteJSONKey(json, bench_percentile_names[i]);
+        WriteJSONDouble(json, RoundMilliseconds(GetPercentile(times, bench_percentiles[i])));
+    }
+    json += '}';
+}
+
+void PrintResultsJSON(const BenchOptions &options, size_t num_files, const BenchResult *results, std::string &json)
+{
+    json += "{\n    ";
+    WriteJSONKey(json, "files");
+    WriteJSONUnsigned(json, num_files);
+    json += ",\n    ";
+    WriteJSONKey(json, "runs");
+    WriteJSONUnsigned(json, options.runs);
+    json += ",\n    ";
+    WriteJSONKey(json, "warmup_runs");
+    WriteJSONUnsigned(json, options.warmup_runs);
+    json += ",\n    ";
+    WriteJSONKey(json, "threads");
+    WriteJSONUnsigned(json, options.num_threads);
+    json += ",\n    ";
+    WriteJSONKey(json, "benchmarks");
+    json += '{';
+    bool first = true;
+    for (size_t i = 0; i < BENCH_COUNT; i++) {
+        if (!options.modes[i]) {
+            continue;
+        }
+        const BenchResult &result = results[i];
+        json += first ? "\n        " : ",\n        ";
+        first = false;
+        WriteJSONKey(json, GetBenchName((BenchMode)i));
+        json += "{\n            ";
+        WriteJSONKey(json, "bytes");
+        WriteJSONUnsigned(json, result.bytes);
+        json += ",\n            ";
+        WriteJSONKey(json, "records");
+        WriteJSONUnsigned(json, result.records);
+        json += ",\n            ";
+        WriteJSONKey(json, "mb_per_s");
+        WriteJSONDouble(json, std::round(GetMBPerSecond(result) * 1000.0) / 1000.0);
+        json += ",\n            ";
+        WriteJSONKey(json, "peak_mb_per_s");
+        WriteJSONDouble(json, std::round(GetPeakMBPerSecond(result) * 1000.0) / 1000.0);
+        json += ",\n            ";
+        WriteJSONKey(json, "records_per_s");
+        WriteJSONDouble(json, std::round(GetRecordsPerSecond(result)));
+        json += ",\n            ";
+        WriteJSONKey(json, "total_ms");
+        PrintPercentilesJSON(json, result.run_times);
+        json += ",\n            ";
+        WriteJSONKey(json, "phases_ms");
+        json += '{';
+        bool first_phase = true;
+        for (size_t j = 0; j < PHASE_COUNT; j++) {
+            if (result.phase_times[j].empty()) {
+                continue;
+            }
+            json += first_phase ? "\n                " : ",\n                ";
+            first_phase = false;
+            WriteJSONKey(json, GetPhaseName((ConversionPhase)j));
+            PrintPercentilesJSON(json, result.phase_times[j]);
+        }
+        json += "\n            }\n        }";
+    }
+    json += "\n    }\n}\n";
+}
+
+bool ReadBaselineBenchmark(JSONReader &reader, double &peak_mb_per_s)
+{
+    peak_mb_per_s = 0.0;
+    std::string_view key;
+    bool first = true;
+    while (ReadJSONKey(reader, key, first)) {
+        first = false;
+        std::string_view text;
+        JSONValueType type = ReadJSONValue(reader, text);
+        if (key == "peak_mb_per_s" && type == JSON_VALUE_LITERAL) {
+            peak_mb_per_s = strtod(std::string(text).c_str(), nullptr);
+        } else if (!SkipJSONValue(reader, type)) {
+            return false;
+        }
+    }
+    return reader.error.empty();
+}
+
+bool ReadBaselineJSON(const std::string &json, std::map<std::string, double> &baseline, std::string &error)
+{
+    //Only peak throughput of each benchmark is compared so other keys are skipped
+    JSONReader reader;
+    InitJSONReader(reader, json.data(), json.size());
+    std::string_view text;
+    if (ReadJSONValue(reader, text) != JSON_VALUE_OBJECT) {
+        error = "Baseline is not a JSON object.";
+        return false;
+    }
+    std::string_view key;
+    bool first = true;
+    while (ReadJSONKey(reader, key, first)) {
+        first = false;
+        JSONValueType type = ReadJSONValue(reader, text);
+        if (key != "benchmarks" || type != JSON_VALUE_OBJECT) {
+            if (!SkipJSONValue(reader, type)) {
+                break;
+            }
+            continue;
+        }
+        bool first_bench = true;
+        while (ReadJSONKey(reader, key, first_bench)) {
+            first_bench = false;
+            std::string name(key);
+            type = ReadJSONValue(reader, text);
+            if (type != JSON_VALUE_OBJECT) {
+                if (!SkipJSONValue(reader, type)) {
+                    break;
+                }
+                continue;
+            }
+            double peak_mb_per_s;
+            if (!ReadBaselineBenchmark(reader, peak_mb_per_s)) {
+                break;
+            }
+            baseline[name] = peak_mb_per_s;
+        }
+    }
+    if (!reader.error.empty() || !FinishJSONReader(reader)) {
+        error = "Invalid baseline. " + reader.error;
+        return false;
+    }
+    return true;
+}
+
+bool CompareBaseline(const BenchOptions &options, const BenchResult *results, bool &regressed)
+{
+    regressed = false;
+    std::vector<uint8_t> data;
+    if (!ReadWholeFile(options.baseline_file, data)) {
+        std::cout << "Failed to read baseline " << options.baseline_file << "." << std::endl;
+        return false;
+    }
+    std::map<std::string, double> baseline;
+    std::string error;
+    if (!ReadBaselineJSON(std::string(data.begin(), data.end()), baseline, error)) {
+        std::cout << error << std::endl;
+        return false;
+    }
+    for (size_t i = 0; i < BENCH_COUNT; i++) {
+        auto iter = baseline.find(GetBenchName((BenchMode)i));
+        if (!options.modes[i] || iter == baseline.end() || iter->second <= 0.0) {
+            continue;
+        }
+        double peak_mb_per_s = GetPeakMBPerSecond(results[i]);
+        double change = (peak_mb_per_s - iter->second) / iter->second * 100.0;
+        bool failed = change < -options.threshold;
+        char line[256];
+        snprintf(line, sizeof(line), "%s: peak %.2f MB/s against baseline peak %.2f MB/s (%+.1f%%)%s", GetBenchName((BenchMode)i), peak_mb_per_s, iter->second, change, failed ? " REGRESSION" : "");
+        std::cout << line << std::endl;
+        regressed = regressed || failed;
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    //Get parameters to program
+    std::vector<std::string> args(argv + 1, argv + argc);
+    BenchOptions options;
+    if (!ParseOptions(args, options)) {
+        return 1;
+    }
+    if (args.empty()) {
+        //Write usage statement
+        std::cout << "Usage: " << argv[0] << " [options] in..." << std::endl;
+        std::cout << "Times dumping, building, and round trips of sprite files in memory." << std::endl;
+        std::cout << "Inputs may be sprite files or directories of them, such as made by spritegen." << std::endl;
+        std::cout << "Options:" << std::endl;
+        std::cout << "-mode {dump|build|round_trip} runs only the given benchmarks, may be repeated" << std::endl;
+        std::cout << "-runs n sets the number of timed runs of each benchmark (default 10)" << std::endl;
+        std::cout << "-warmup n sets the number of untimed runs before them (default 2)" << std::endl;
+        std::cout << "-cpu n pins the benchmark to CPU n" << std::endl;
+        std::cout << "-j threads sets the number of threads used to parse large XML files (default 1)" << std::endl;
+        std::cout << "-json file writes results to file as JSON" << std::endl;
+        std::cout << "-baseline file compares throughput of fastest runs with results JSON from an earlier run" << std::endl;
+        std::cout << "-threshold percent fails if throughput drops more than percent below baseline (default 15)" << std::endl;
+        return 1;
+    }
+    if (options.cpu >= 0 && !PinToCPU(options.cpu)) {
+        std::cout << "Failed to pin to CPU " << options.cpu << "." << std::endl;
+        return 1;
+    }
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < args.size(); i++) {
+        AddInputPaths(args[i], paths);
+    }
+    if (paths.empty()) {
+        std::cout << "No sprite files found." << std::endl;
+        return 1;
+    }
+    std::vector<BenchFile> files(paths.size());
+    for (size_t i = 0; i < paths.size(); i++) {
+        if (!LoadBenchFile(paths[i], files[i])) {
+            return 1;
+        }
+    }
+    BenchResult results[BENCH_COUNT];
+    for (size_t i = 0; i < BENCH_COUNT; i++) {
+        if (!options.modes[i]) {
+            continue;
+        }
+        if (!RunBenchmark(options, (BenchMode)i, files, results[i])) {
+            return 1;
+        }
+        std::string text;
+        PrintResultText((BenchMode)i, results[i], text);
+        std::cout << text;
+        if (results[i].round_trip_mismatch) {
+            std::cout << "Warning: Some round trips did not reproduce their input sprite file." << std::endl;
+        }
+    }
+    if (!options.json_file.empty()) {
+        std::string json;
+        PrintResultsJSON(options, files.size(), results, json);
+        if (!WriteOutputFile(options.json_file, json.data(), json.size())) {
+            std::cout << "Failed to open " << options.json_file << " for writing." << std::endl;
+            return 1;
+        }
+    }
+    if (!options.baseline_file.empty()) {
+        bool regressed;
+        if (!CompareBaseline(options, results, regressed)) {
+            return 1;
+        }
+        if (regressed) {
+            std::cout << "Throughput dropped more than " << options.threshold << "% below baseline." << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
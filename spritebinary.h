@@ -0,0 +1,33 @@
+#ifndef SPRITEBINARY_H
+#define SPRITEBINARY_H
+
+#include <stdint.h>
+#include "spritelib.h"
+
+//Readers of little-endian sprite file fields, safe at any alignment
+uint8_t ReadU8(const uint8_t *src);
+int8_t ReadS8(const uint8_t *src);
+bool ReadBool(const uint8_t *src);
+uint16_t ReadU16(const uint8_t *src);
+int16_t ReadS16(const uint8_t *src);
+uint32_t ReadU32(const uint8_t *src);
+int32_t ReadS32(const uint8_t *src);
+float ReadFloat(const uint8_t *src);
+
+//Writers of little-endian sprite file fields, safe at any alignment
+void WriteU8(uint8_t *dst, uint8_t value);
+void WriteS8(uint8_t *dst, int8_t value);
+void WriteBool(uint8_t *dst, bool value);
+void WriteU16(uint8_t *dst, uint16_t value);
+void WriteS16(uint8_t *dst, int16_t value);
+void WriteU32(uint8_t *dst, uint32_t value);
+void WriteS32(uint8_t *dst, int32_t value);
+void WriteFloat(uint8_t *dst, float value);
+
+//Decode and encode 28-byte animation frame and image records
+void ReadAnimFrame(const uint8_t *src, AnimFrame &frame);
+void ReadImage(const uint8_t *src, Image &image);
+void WriteAnimFrame(uint8_t *dst, const AnimFrame &frame, int16_t anim_idx, int16_t next_frame);
+void WriteImage(uint8_t *dst, const Image &image);
+
+#endif
@@ -0,0 +1,282 @@
+#define _CRT_SECURE_NO_WARNINGS //Shut up Visual Studio
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "spritelib.h"
+
+//Generates sprite files with random contents for benchmarking conversions
+
+struct GenOptions {
+    uint64_t seed;
+    unsigned long sprite_count;
+    unsigned long anim_count;
+    unsigned long frame_count; //Frames of all animations
+    unsigned long image_count; //Images of all sprites
+};
+
+//Random numbers from xorshift64* so output is the same with every compiler and standard library
+struct GenRandom {
+    uint64_t state;
+};
+
+void SeedRandom(GenRandom &random, uint64_t seed)
+{
+    //Mix seed with splitmix64 so nearby seeds give unrelated sequences and 0 is a valid seed
+    uint64_t z = seed + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    random.state = (z ^ (z >> 31)) | 1;
+}
+
+uint64_t NextRandom(GenRandom &random)
+{
+    random.state ^= random.state >> 12;
+    random.state ^= random.state << 25;
+    random.state ^= random.state >> 27;
+    return random.state * 0x2545F4914F6CDD1DULL;
+}
+
+int32_t RandomRange(GenRandom &random, int32_t min, int32_t max)
+{
+    //Inclusive range, bias from modulo is too small to matter here
+    uint64_t range = (uint64_t)((int64_t)max - min) + 1;
+    return (int32_t)(min + (int64_t)(NextRandom(random) % range));
+}
+
+bool RandomChance(GenRandom &random, int32_t percent)
+{
+    return RandomRange(random, 0, 99) < percent;
+}
+
+void SplitCount(GenRandom &random, unsigned long total, unsigned long parts, std::vector<uint16_t> &counts)
+{
+    //Give every part one item if possible and spread the rest between random cut points
+    counts.assign(parts, 0);
+    if (parts == 0) {
+        return;
+    }
+    unsigned long min_count = (total >= parts) ? 1 : 0;
+    int32_t remaining = (int32_t)(total - (min_count * parts));
+    std::vector<int32_t> cuts(parts - 1);
+    for (size_t i = 0; i < cuts.size(); i++) {
+        cuts[i] = RandomRange(random, 0, remaining);
+    }
+    std::sort(cuts.begin(), cuts.end());
+    int32_t prev_cut = 0;
+    for (size_t i = 0; i < parts; i++) {
+        int32_t cut = (i < cuts.size()) ? cuts[i] : remaining;
+        counts[i] = (uint16_t)(min_count + cut - prev_cut);
+        prev_cut = cut;
+    }
+}
+
+void GenerateImage(GenRandom &random, Image &image)
+{
+    //Images are cut from a few large texture atlases
+    image.texture_id = (uint16_t)RandomRange(random, 0, 63);
+    image.num_palettes = RandomChance(random, 90) ? 1 : (uint16_t)RandomRange(random, 2, 16);
+    image.w = (uint16_t)RandomRange(random, 8, 256);
+    image.h = (uint16_t)RandomRange(random, 8, 256);
+    image.src_x = (uint16_t)RandomRange(random, 0, 2048 - image.w);
+    image.src_y = (uint16_t)RandomRange(random, 0, 2048 - image.h);
+    //Images are placed roughly centered on sprite origin
+    image.x = (int16_t)(RandomRange(random, -16, 16) - (image.w / 2));
+    image.y = (int16_t)(RandomRange(random, -16, 16) - (image.h / 2));
+    //Most images keep default optional attributes
+    image.alpha_mode = RandomChance(random, 85) ? 0 : (uint8_t)RandomRange(random, 1, 3);
+    image.angle = RandomChance(random, 90) ? 0 : (int16_t)RandomRange(random, 0, 4095);
+    int32_t blend_roll = RandomRange(random, 0, 99);
+    if (blend_roll < 80) {
+        image.blend_mode = 0;
+    } else if (blend_roll < 90) {
+        image.blend_mode = 1;
+    } else {
+        image.blend_mode = (uint8_t)RandomRange(random, 2, 3);
+    }
+    image.bilinear = RandomChance(random, 20);
+    image.flip = RandomChance(random, 85) ? 0 : (uint8_t)RandomRange(random, 1, 3);
+}
+
+float RandomFrameScale(GenRandom &random)
+{
+    if (RandomChance(random, 85)) {
+        return 1.0f;
+    }
+    //Eighths print exactly in XML and JSON
+    float scale = RandomRange(random, 4, 16) / 8.0f;
+    return RandomChance(random, 30) ? -scale : scale;
+}
+
+float RandomFrameOffset(GenRandom &random)
+{
+    if (RandomChance(random, 80)) {
+        return 0.0f;
+    }
+    return RandomRange(random, -128, 128) / 2.0f;
+}
+
+void GenerateFrame(GenRandom &random, AnimFrame &frame)
+{
+    //Short delays are most common
+    frame.delay = RandomChance(random, 70) ? (uint8_t)RandomRange(random, 1, 8) : (uint8_t)RandomRange(random, 0, 60);
+    frame.max_delay = 0;
+    if (RandomChance(random, 15)) {
+        frame.max_delay = (uint8_t)std::min(frame.delay + RandomRange(random, 1, 8), 255);
+    }
+    frame.x_scale = RandomFrameScale(random);
+    frame.y_scale = RandomChance(random, 70) ? frame.x_scale : RandomFrameScale(random);
+    frame.x = RandomFrameOffset(random);
+    frame.y = RandomFrameOffset(random);
+    frame.angle = RandomChance(random, 90) ? 0 : (int16_t)RandomRange(random, 0, 4095);
+}
+
+void GenerateProject(const GenOptions &options, SpriteProject &project)
+{
+    GenRandom random;
+    SeedRandom(random, options.seed);
+    std::vector<uint16_t> counts;
+    SplitCount(random, options.image_count, options.sprite_count, counts);
+    project.sprite_list.resize(options.sprite_count);
+    for (size_t i = 0; i < project.sprite_list.size(); i++) {
+        Sprite &sprite = project.sprite_list[i];
+        //Same names as dumps of sprite files use so dumping the output gives back the XML
+        sprite.name = "sprite" + std::to_string(i);
+        sprite.min_x = sprite.min_y = sprite.max_x = sprite.max_y = 0;
+        sprite.images.resize(counts[i]);
+        for (size_t j = 0; j < sprite.images.size(); j++) {
+            GenerateImage(random, sprite.images[j]);
+        }
+    }
+    SplitCount(random, options.frame_count, options.anim_count, counts);
+    project.anim_list.resize(options.anim_count);
+    for (size_t i = 0; i < project.anim_list.size(); i++) {
+        std::vector<AnimFrame> &anim = project.anim_list[i];
+        anim.resize(counts[i]);
+        //Animations mostly step through runs of neighboring sprites
+        int32_t sprite_idx = 0;
+        for (size_t j = 0; j < anim.size(); j++) {
+            if (j == 0 || RandomChance(random, 10)) {
+                sprite_idx = RandomRange(random, 0, (int32_t)options.sprite_count - 1);
+            }
+            anim[j].sprite_idx = (uint16_t)sprite_idx;
+            GenerateFrame(random, anim[j]);
+            sprite_idx = (sprite_idx + 1) % options.sprite_count;
+        }
+    }
+}
+
+bool ParseCount(std::string name, std::string value, unsigned long &count)
+{
+    //Header counts are 16-bit
+    char *end;
+    count = strtoul(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0' || count > UINT16_MAX) {
+        std::cout << "Invalid " << name << " count " << value << ". Counts must be from 0 to " << UINT16_MAX << "." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool ParseOptions(std::vector<std::string> &args, GenOptions &options)
+{
+    options.seed = 1;
+    options.sprite_count = 1000;
+    options.anim_count = 500;
+    options.frame_count = 4000;
+    options.image_count = 3000;
+    //Remove options and keep remaining arguments in order
+    std::vector<std::string> remaining;
+    for (size_t i = 0; i < args.size(); i++) {
+        bool valid = true;
+        if (args[i] == "-seed" && i + 1 < args.size()) {
+            options.seed = strtoull(args[++i].c_str(), nullptr, 10);
+        } else if (args[i] == "-sprites" && i + 1 < args.size()) {
+            valid = ParseCount("sprite", args[++i], options.sprite_count);
+        } else if (args[i] == "-anims" && i + 1 < args.size()) {
+            valid = ParseCount("animation", args[++i], options.anim_count);
+        } else if (args[i] == "-frames" && i + 1 < args.size()) {
+            valid = ParseCount("frame", args[++i], options.frame_count);
+        } else if (args[i] == "-images" && i + 1 < args.size()) {
+            valid = ParseCount("image", args[++i], options.image_count);
+        } else {
+            remaining.push_back(args[i]);
+        }
+        if (!valid) {
+            return false;
+        }
+    }
+    args = remaining;
+    //Items need somewhere to go
+    if (options.image_count > 0 && options.sprite_count == 0) {
+        std::cout << "Images need at least one sprite." << std::endl;
+        return false;
+    }
+    if (options.frame_count > 0 && (options.anim_count == 0 || options.sprite_count == 0)) {
+        std::cout << "Frames need at least one animation and sprite." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool HasJSONExtension(std::string path)
+{
+    size_t extension_pos = path.find_last_of('.');
+    if (extension_pos == std::string::npos) {
+        return false;
+    }
+    std::string extension = path.substr(extension_pos);
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)tolower(c); });
+    return extension == ".json";
+}
+
+int main(int argc, char **argv)
+{
+    //Get parameters to program
+    std::vector<std::string> args(argv + 1, argv + argc);
+    GenOptions options;
+    if (!ParseOptions(args, options)) {
+        return 1;
+    }
+    if (args.size() < 1 || args.size() > 2) {
+        //Write usage statement
+        std::cout << "Usage: " << argv[0] << " [options] out.spr [out.xml]" << std::endl;
+        std::cout << "Writes a sprite file with random contents and optionally the matching XML, or JSON if the name ends in .json." << std::endl;
+        std::cout << "The same options and seed always give the same files." << std::endl;
+        std::cout << "Options:" << std::endl;
+        std::cout << "-seed n sets the random seed (default 1)" << std::endl;
+        std::cout << "-sprites n sets the number of sprites (default 1000)" << std::endl;
+        std::cout << "-anims n sets the number of animations (default 500)" << std::endl;
+        std::cout << "-frames n sets the number of frames spread over all animations (default 4000)" << std::endl;
+        std::cout << "-images n sets the number of images spread over all sprites (default 3000)" << std::endl;
+        std::cout << "Counts may be up to " << UINT16_MAX << "." << std::endl;
+        return 1;
+    }
+    ConversionContext context;
+    GenerateProject(options, context.project);
+    std::vector<uint8_t> buffer;
+    if (!EncodeSprite(context, buffer)) {
+        std::cout << "Failed to encode " << args[0] << ". " << context.error << std::endl;
+        return 1;
+    }
+    if (!WriteOutputFile(args[0], buffer.data(), buffer.size())) {
+        std::cout << "Failed to open " << args[0] << " for writing." << std::endl;
+        return 1;
+    }
+    if (args.size() == 2) {
+        std::string text;
+        bool printed = HasJSONExtension(args[1]) ? PrintSpriteJSON(context, text) : PrintSpriteXML(context, text);
+        if (!printed) {
+            std::cout << "Failed to print " << args[1] << ". " << context.error << std::endl;
+            return 1;
+        }
+        if (!WriteOutputFile(args[1], text.data(), text.size())) {
+            std::cout << "Failed to open " << args[1] << " for writing." << std::endl;
+            return 1;
+        }
+    }
+    std::cout << "Generated " << options.sprite_count << " sprites, " << options.image_count << " images, " << options.anim_count << " animations, and " << options.frame_count << " frames with seed " << options.seed << "." << std::endl;
+    return 0;
+}
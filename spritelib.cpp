@@ -0,0 +1,2877 @@
+#define _CRT_SECURE_NO_WARNINGS //Shut up Visual Studio
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <atomic>
+#include <filesystem>
+#include <charconv>
+#include <cmath>
+#include <algorithm>
+#include <iterator>
+#include <deque>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "tinyxml2.h"
+#include "xmlreader.h"
+#include "json.h"
+#include "spritelib.h"
+#include "spritebinary.h"
+#include "parallel.h"
+
+struct InputFile {
+    const uint8_t *data;
+    size_t size;
+    bool mapped; //Data is a view of the file instead of buffer
+    std::vector<uint8_t> buffer; //Holds file contents if mapping is unavailable
+#ifdef _WIN32
+    HANDLE file_handle;
+    HANDLE mapping_handle;
+#endif
+};
+
+bool SetError(ConversionContext &context, std::string error)
+{
+    //Always returns false so failures can be returned directly
+    context.error = error;
+    return false;
+}
+
+bool MapInputFile(std::string path, InputFile &file)
+{
+    file.data = nullptr;
+    file.size = 0;
+    file.mapped = false;
+#ifdef _WIN32
+    file.file_handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    file.mapping_handle = nullptr;
+    if (file.file_handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    //Only disk files can be mapped
+    LARGE_INTEGER size;
+    if (GetFileType(file.file_handle) != FILE_TYPE_DISK || !GetFileSizeEx(file.file_handle, &size) || size.QuadPart == 0) {
+        CloseHandle(file.file_handle);
+        file.file_handle = INVALID_HANDLE_VALUE;
+        return false;
+    }
+    file.mapping_handle = CreateFileMappingA(file.file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (file.mapping_handle) {
+        file.data = (const uint8_t *)MapViewOfFile(file.mapping_handle, FILE_MAP_READ, 0, 0, 0);
+    }
+    if (!file.data) {
+        //Release handles if mapping failed
+        if (file.mapping_handle) {
+            CloseHandle(file.mapping_handle);
+            file.mapping_handle = nullptr;
+        }
+        CloseHandle(file.file_handle);
+        file.file_handle = INVALID_HANDLE_VALUE;
+        return false;
+    }
+    file.size = size.QuadPart;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    //Only regular files can be mapped
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    void *data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); //Mapping stays valid after closing descriptor
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    madvise(data, info.st_size, MADV_SEQUENTIAL);
+    file.data = (const uint8_t *)data;
+    file.size = info.st_size;
+#endif
+    file.mapped = true;
+    return true;
+}
+
+bool ReadInputFile(std::string path, InputFile &file)
+{
+    //Fallback for pipes and other streams which cannot be mapped
+    FILE *stream = fopen(path.c_str(), "rb");
+    if (!stream) {
+        return false;
+    }
+    uint8_t temp[65536];
+    size_t num_read;
+    while ((num_read = fread(temp, 1, sizeof(temp), stream)) != 0) {
+        file.buffer.insert(file.buffer.end(), temp, temp + num_read);
+    }
+    bool success = !ferror(stream);
+    fclose(stream);
+    file.data = file.buffer.data();
+    file.size = file.buffer.size();
+    file.mapped = false;
+    return success;
+}
+
+bool OpenInputFile(std::string path, InputFile &file)
+{
+    //Try mapping file before reading it through stdio
+    if (MapInputFile(path, file)) {
+        return true;
+    }
+    return ReadInputFile(path, file);
+}
+
+void CloseInputFile(InputFile &file)
+{
+    if (file.mapped) {
+#ifdef _WIN32
+        UnmapViewOfFile(file.data);
+        CloseHandle(file.mapping_handle);
+        CloseHandle(file.file_handle);
+#else
+        munmap((void *)file.data, file.size);
+#endif
+    }
+    //Release fallback buffer
+    std::vector<uint8_t>().swap(file.buffer);
+    file.data = nullptr;
+    file.size = 0;
+    file.mapped = false;
+}
+
+uint8_t ReadU8(const uint8_t *src)
+{
+    return src[0];
+}
+
+int8_t ReadS8(const uint8_t *src)
+{
+    //Same as reading unsigned version
+    return ReadU8(src);
+}
+
+bool ReadBool(const uint8_t *src)
+{
+    //Bools are implemented as unsigned 8-bit integers in c++
+    return ReadU8(src);
+}
+
+uint16_t ReadU16(const uint8_t *src)
+{
+    //Return bytes in little-endian order
+    return (src[1] << 8) | src[0];
+}
+
+int16_t ReadS16(const uint8_t *src)
+{
+    return ReadU16(src);
+}
+
+uint32_t ReadU32(const uint8_t *src)
+{
+    //Return bytes in little-endian order
+    return ((uint32_t)src[3] << 24) | (src[2] << 16) | (src[1] << 8) | src[0];
+}
+
+int32_t ReadS32(const uint8_t *src)
+{
+    return ReadU32(src);
+}
+
+float ReadFloat(const uint8_t *src)
+{
+    uint32_t raw = ReadU32(src);
+    float value;
+    memcpy(&value, &raw, sizeof(value)); //Reinterpret 4 bytes as float
+    return value;
+}
+
+void WriteU8(uint8_t *dst, uint8_t value)
+{
+    dst[0] = value;
+}
+
+void WriteS8(uint8_t *dst, int8_t value)
+{
+    dst[0] = value;
+}
+
+void WriteBool(uint8_t *dst, bool value)
+{
+    //Bools are implemented as 8-bit integers in c++
+    WriteU8(dst, value);
+}
+
+void WriteU16(uint8_t *dst, uint16_t value)
+{
+    //Write bytes in little-endian order
+    dst[1] = value >> 8;
+    dst[0] = value & 0xFF;
+}
+
+void WriteS16(uint8_t *dst, int16_t value)
+{
+    WriteU16(dst, value);
+}
+
+void WriteU32(uint8_t *dst, uint32_t value)
+{
+    //Write bytes in little-endian order
+    dst[3] = value >> 24;
+    dst[2] = (value >> 16) & 0xFF;
+    dst[1] = (value >> 8) & 0xFF;
+    dst[0] = value & 0xFF;
+}
+
+void WriteS32(uint8_t *dst, int32_t value)
+{
+    WriteU32(dst, value);
+}
+
+void WriteFloat(uint8_t *dst, float value)
+{
+    uint32_t raw;
+    memcpy(&raw, &value, sizeof(raw)); //Get the bits of the float
+    WriteU32(dst, raw);
+}
+
+void ReadSpriteHeader(const uint8_t *src, SpriteHeader &header)
+{
+    //Read count fields
+    header.sprite_count = ReadU16(&src[0]);
+    header.anim_count = ReadU16(&src[2]);
+    header.frame_count = ReadU16(&src[4]);
+    header.image_count = ReadU16(&src[6]);
+    //Read offset fields
+    header.sprite_ofs = ReadU32(&src[8]);
+    header.anim_ofs = ReadU32(&src[12]);
+    header.frame_ofs = ReadU32(&src[16]);
+    header.image_ofs = ReadU32(&src[20]);
+}
+
+bool VerifySpriteHeader(SpriteHeader &header, size_t file_size)
+{
+    //Check if end of each section exceeds end of file
+    bool anim_valid = ((uint64_t)header.anim_ofs + (4 * header.anim_count)) <= file_size;
+    bool frame_valid = ((uint64_t)header.frame_ofs + (28 * header.frame_count)) <= file_size;
+    bool sprite_valid = ((uint64_t)header.sprite_ofs + (12 * header.sprite_count)) <= file_size;
+    bool image_valid = ((uint64_t)header.image_ofs + (28 * header.image_count)) <= file_size;
+    return anim_valid && frame_valid && sprite_valid && image_valid;
+}
+
+void ReadAnimFrame(const uint8_t *src, AnimFrame &frame)
+{
+    //Read sprite index
+    frame.sprite_idx = ReadU16(&src[0]);
+    //Read delay fields
+    frame.delay = ReadU8(&src[2]);
+    frame.max_delay = ReadU8(&src[3]);
+    //Read scale fields
+    frame.x_scale = ReadFloat(&src[4]);
+    frame.y_scale = ReadFloat(&src[8]);
+    //Read position fields
+    frame.x = ReadFloat(&src[12]);
+    frame.y = ReadFloat(&src[16]);
+    //Read angle
+    frame.angle = ReadS16(&src[20]);
+    //Animation ID, next frame, and padding field are ignored
+}
+
+void ReadImage(const uint8_t *src, Image &image)
+{
+    image.texture_id = ReadU16(&src[0]); //Read texture ID
+    image.num_palettes = ReadU16(&src[2]); //Read palette count
+    //Read image position
+    image.x = ReadS16(&src[4]);
+    image.y = ReadS16(&src[6]);
+    //Read image source position
+    image.src_x = ReadU16(&src[8]);
+    image.src_y = ReadU16(&src[10]);
+    //Read image size
+    image.w = ReadU16(&src[12]);
+    image.h = ReadU16(&src[14]);
+    //Skip unknown field
+    image.alpha_mode = ReadU8(&src[17]); //Read image alpha mode
+    //Skip 2 unknown fields
+    image.angle = ReadS16(&src[20]); //Read image angle
+    image.blend_mode = ReadU8(&src[22]); //Read image blend mode
+    image.bilinear = ReadBool(&src[23]); //Read image bilinear filter flag
+    image.flip = ReadU8(&src[24]); //Read image flip flags
+    //Skip 3 unknown fields
+}
+
+bool ReadAnims(SpriteProject &project, const uint8_t *data, size_t size, SpriteHeader &header)
+{
+    const uint8_t *anim_data = &data[header.anim_ofs];
+    for (uint16_t i = 0; i < header.anim_count; i++) {
+        //Read animation frame range
+        uint16_t start_frame = ReadU16(&anim_data[(i * 4) + 0]);
+        uint16_t num_frames = ReadU16(&anim_data[(i * 4) + 2]);
+        //Check if frame range exceeds end of file
+        if (header.frame_ofs + ((uint64_t)start_frame + num_frames) * 28 > size) {
+            return false;
+        }
+        std::vector<AnimFrame> anim;
+        anim.reserve(num_frames);
+        //Read frames for each animation
+        const uint8_t *frame_data = &data[header.frame_ofs + (start_frame * 28)];
+        for (uint16_t j = 0; j < num_frames; j++) {
+            AnimFrame frame;
+            ReadAnimFrame(&frame_data[j * 28], frame);
+            anim.push_back(frame); //Add frame to animation
+        }
+        project.anim_list.push_back(anim);
+    }
+    return true;
+}
+
+bool ReadSprites(SpriteProject &project, const uint8_t *data, size_t size, SpriteHeader &header)
+{
+    const uint8_t *sprite_data = &data[header.sprite_ofs];
+    for (uint16_t i = 0; i < header.sprite_count; i++) {
+        Sprite sprite;
+        const uint8_t *src = &sprite_data[i * 12];
+        //Read sprite image ranges
+        uint16_t start_image = ReadU16(&src[0]);
+        uint16_t num_images = ReadU16(&src[2]);
+        //Convert sprite index to name
+        sprite.name = "sprite" + std::to_string(i);
+        //Read sprite bounding rectangle
+        sprite.min_x = ReadS16(&src[4]);
+        sprite.min_y = ReadS16(&src[6]);
+        sprite.max_x = ReadS16(&src[8]);
+        sprite.max_y = ReadS16(&src[10]);
+        //Check if image range exceeds end of file
+        if (header.image_ofs + ((uint64_t)start_image + num_images) * 28 > size) {
+            return false;
+        }
+        //Read images for sprite
+        const uint8_t *image_data = &data[header.image_ofs + (start_image * 28)];
+        sprite.images.resize(num_images);
+        for (uint16_t j = 0; j < num_images; j++) {
+            ReadImage(&image_data[j * 28], sprite.images[j]);
+        }
+        project.sprite_list.push_back(sprite);
+    }
+    return true;
+}
+
+float GetImageAlpha(uint8_t value)
+{
+    if (value >= 4) {
+        //Game treats image modes greater than 4 as full alpha
+        return 1.0f;
+    }
+    //Game treats values 0-3 as 100% to 25%
+    return (4 - value) * 0.25f;
+}
+
+uint8_t GetAlphaModeValue(float alpha)
+{
+    //Use midpoint check for alpha value
+    if (alpha > 0.875f) {
+        return 0;
+    } else if (alpha > 0.625f) {
+        return 1;
+    } else if (alpha > 0.375f) {
+        return 2;
+    } else {
+        return 3;
+    }
+}
+
+uint8_t GetBlendModeValue(std::string_view name)
+{
+    const char *mode_names[3] = { "normal", "additive", "mask" };
+    for (size_t i = 0; i < 3; i++) {
+        if (name == mode_names[i]) {
+            //Found blend mode with proper name
+            return i;
+        }
+    }
+    //Use none blend mode if not found
+    return 3;
+}
+
+const char *GetBlendModeName(uint8_t value)
+{
+    const char *names[3] = { "normal", "additive", "mask" };
+    if (value >= 3) {
+        //Replace invalid blend modes with none
+        return "none";
+    }
+    //Read blend mode name from table
+    return names[value];
+}
+
+//Attributes of image elements in the order they are written
+enum ImageAttribute {
+    IMAGE_ATTR_TEXTURE_ID,
+    IMAGE_ATTR_NUM_PALETTES,
+    IMAGE_ATTR_SRC_X,
+    IMAGE_ATTR_SRC_Y,
+    IMAGE_ATTR_X,
+    IMAGE_ATTR_Y,
+    IMAGE_ATTR_W,
+    IMAGE_ATTR_H,
+    IMAGE_ATTR_ALPHA,
+    IMAGE_ATTR_ANGLE,
+    IMAGE_ATTR_BLEND_MODE,
+    IMAGE_ATTR_BILINEAR,
+    IMAGE_ATTR_FLIP_X,
+    IMAGE_ATTR_FLIP_Y,
+    IMAGE_ATTR_COUNT
+};
+
+//Attributes of frame elements in the order they are written
+enum FrameAttribute {
+    FRAME_ATTR_SPRITE,
+    FRAME_ATTR_DELAY,
+    FRAME_ATTR_MAX_DELAY,
+    FRAME_ATTR_X_SCALE,
+    FRAME_ATTR_Y_SCALE,
+    FRAME_ATTR_X,
+    FRAME_ATTR_Y,
+    FRAME_ATTR_ANGLE,
+    FRAME_ATTR_COUNT
+};
+
+struct AttributeSchema {
+    const char *name;
+    int id;
+    bool required;
+};
+
+//Entries before the count are indexed by ID and give the name written by dumps
+const AttributeSchema image_schema[] = {
+    { "texture_id", IMAGE_ATTR_TEXTURE_ID, true },
+    { "num_palettes", IMAGE_ATTR_NUM_PALETTES, false },
+    { "src_x", IMAGE_ATTR_SRC_X, true },
+    { "src_y", IMAGE_ATTR_SRC_Y, true },
+    { "x", IMAGE_ATTR_X, true },
+    { "y", IMAGE_ATTR_Y, true },
+    { "w", IMAGE_ATTR_W, true },
+    { "h", IMAGE_ATTR_H, true },
+    { "alpha", IMAGE_ATTR_ALPHA, false },
+    { "angle", IMAGE_ATTR_ANGLE, false },
+    { "blend_mode", IMAGE_ATTR_BLEND_MODE, false },
+    { "bilinear", IMAGE_ATTR_BILINEAR, false },
+    { "flip_x", IMAGE_ATTR_FLIP_X, false },
+    { "flip_y", IMAGE_ATTR_FLIP_Y, false }
+};
+
+const AttributeSchema frame_schema[] = {
+    { "sprite", FRAME_ATTR_SPRITE, true },
+    { "delay", FRAME_ATTR_DELAY, false },
+    { "max_delay", FRAME_ATTR_MAX_DELAY, false },
+    { "x_scale", FRAME_ATTR_X_SCALE, false },
+    { "y_scale", FRAME_ATTR_Y_SCALE, false },
+    { "x", FRAME_ATTR_X, false },
+    { "y", FRAME_ATTR_Y, false },
+    { "angle", FRAME_ATTR_ANGLE, false },
+    //Older versions dumped max delay under this name
+    { "delay_range", FRAME_ATTR_MAX_DELAY, false }
+};
+
+const char *GetImageAttributeName(ImageAttribute id)
+{
+    return image_schema[id].name;
+}
+
+const char *GetFrameAttributeName(FrameAttribute id)
+{
+    return frame_schema[id].name;
+}
+
+void PushIntAttribute(tinyxml2::XMLPrinter &printer, const char *name, int value)
+{
+    char buf[16];
+    *std::to_chars(buf, buf + sizeof(buf) - 1, value).ptr = '\0';
+    printer.PushAttribute(name, buf);
+}
+
+void PushFloatAttribute(tinyxml2::XMLPrinter &printer, const char *name, float value)
+{
+    //Write shortest string that reads back as the same float
+    char buf[32];
+    *std::to_chars(buf, buf + sizeof(buf) - 1, value).ptr = '\0';
+    printer.PushAttribute(name, buf);
+}
+
+void PrintAnimFrame(tinyxml2::XMLPrinter &printer, const AnimFrame &frame, const char *sprite_name)
+{
+    printer.OpenElement("frame");
+    printer.PushAttribute(GetFrameAttributeName(FRAME_ATTR_SPRITE), sprite_name);
+    //Write non-default delay
+    if (frame.delay != 1) {
+        PushIntAttribute(printer, GetFrameAttributeName(FRAME_ATTR_DELAY), frame.delay);
+    }
+    //Write non-default max delay
+    if (frame.max_delay != 0) {
+        PushIntAttribute(printer, GetFrameAttributeName(FRAME_ATTR_MAX_DELAY), frame.max_delay);
+    }
+    //Write non-default scale
+    if (frame.x_scale != 1.0f) {
+        PushFloatAttribute(printer, GetFrameAttributeName(FRAME_ATTR_X_SCALE), frame.x_scale);
+    }
+    if (frame.y_scale != 1.0f) {
+        PushFloatAttribute(printer, GetFrameAttributeName(FRAME_ATTR_Y_SCALE), frame.y_scale);
+    }
+    //Write non-default position, including negative zero so it is kept
+    if (frame.x != 0.0f || std::signbit(frame.x)) {
+        PushFloatAttribute(printer, GetFrameAttributeName(FRAME_ATTR_X), frame.x);
+    }
+    if (frame.y != 0.0f || std::signbit(frame.y)) {
+        PushFloatAttribute(printer, GetFrameAttributeName(FRAME_ATTR_Y), frame.y);
+    }
+    //Write non-default angle
+    if (frame.angle != 0) {
+        PushIntAttribute(printer, GetFrameAttributeName(FRAME_ATTR_ANGLE), frame.angle);
+    }
+    printer.CloseElement();
+}
+
+void PrintImage(tinyxml2::XMLPrinter &printer, const Image &image)
+{
+    printer.OpenElement("image");
+    PushIntAttribute(printer, GetImageAttributeName(IMAGE_ATTR_TEXTURE_ID), image.texture_id);
+    //Write number of palettes if more than 1
+    if (image.num_palettes > 1) {
+        PushIntAttribute(printer, GetImageAttributeName(IMAGE_ATTR_NUM_PALETTES), image.num_palettes);
+    }
+    //Write source position of image
+    PushIntAttribute(printer, GetImageAttributeName(IMAGE_ATTR_SRC_X), image.src_x);
+    PushIntAttribute(printer, GetImageAttributeName(IMAGE_ATTR_SRC_Y), image.src_y);
+    //Write position of image
+    PushIntAttribute(printer, GetImageAttributeName(IMAGE_ATTR_X), image.x);
+    PushIntAttribute(printer, GetImageAttributeName(IMAGE_ATTR_Y), image.y);
+    //Write size of image
+    PushIntAttribute(printer, GetImageAttributeName(IMAGE_ATTR_W), image.w);
+    PushIntAttribute(printer, GetImageAttributeName(IMAGE_ATTR_H), image.h);
+    //Write non-default alpha mode
+    if (image.alpha_mode != 0) {
+        PushFloatAttribute(printer, GetImageAttributeName(IMAGE_ATTR_ALPHA), GetImageAlpha(image.alpha_mode));
+    }
+    //Write non-zero angle
+    if (image.angle != 0) {
+        PushIntAttribute(printer, GetImageAttributeName(IMAGE_ATTR_ANGLE), image.angle);
+    }
+    //Write non-default blend mode
+    if (image.blend_mode != 0) {
+        printer.PushAttribute(GetImageAttributeName(IMAGE_ATTR_BLEND_MODE), GetBlendModeName(image.blend_mode));
+    }
+    //Write bilinear flag if used
+    if (image.bilinear) {
+        printer.PushAttribute(GetImageAttributeName(IMAGE_ATTR_BILINEAR), image.bilinear);
+    }
+    //Write flip flags
+    if (image.flip & 0x1) {
+        printer.PushAttribute(GetImageAttributeName(IMAGE_ATTR_FLIP_X), true);
+    }
+    if (image.flip & 0x2) {
+        printer.PushAttribute(GetImageAttributeName(IMAGE_ATTR_FLIP_Y), true);
+    }
+    printer.CloseElement();
+}
+
+void GetIndexedSpriteName(uint16_t sprite_idx, char *buf, size_t size)
+{
+    //Dumped sprites are named after their index
+    snprintf(buf, size, "sprite%u", (unsigned)sprite_idx);
+}
+
+bool PrintSpriteXML(ConversionContext &context, std::string &xml)
+{
+    PhaseScope scope(context, PHASE_PRINT);
+    SpriteProject &project = context.project;
+    tinyxml2::XMLPrinter printer;
+    printer.OpenElement("spritedata");
+    //Write animation sequences
+    char name_buf[16];
+    for (size_t i = 0; i < project.anim_list.size(); i++) {
+        printer.OpenElement("anim");
+        for (size_t j = 0; j < project.anim_list[i].size(); j++) {
+            uint16_t sprite_idx = project.anim_list[i][j].sprite_idx;
+            if (sprite_idx < project.sprite_list.size()) {
+                PrintAnimFrame(printer, project.anim_list[i][j], project.sprite_list[sprite_idx].name.c_str());
+            } else {
+                //Use name derived from index for sprites outside of file
+                GetIndexedSpriteName(sprite_idx, name_buf, sizeof(name_buf));
+                PrintAnimFrame(printer, project.anim_list[i][j], name_buf);
+            }
+        }
+        printer.CloseElement();
+    }
+    //Write sprites
+    for (size_t i = 0; i < project.sprite_list.size(); i++) {
+        printer.OpenElement("sprite");
+        printer.PushAttribute("name", project.sprite_list[i].name.c_str());
+        for (size_t j = 0; j < project.sprite_list[i].images.size(); j++) {
+            PrintImage(printer, project.sprite_list[i].images[j]);
+        }
+        printer.CloseElement();
+    }
+    printer.CloseElement();
+    xml.assign(printer.CStr(), printer.CStrSize() - 1);
+    return true;
+}
+
+void CountSpriteRecords(ConversionStats &stats, const SpriteHeader &header)
+{
+    stats.sprites += header.sprite_count;
+    stats.anims += header.anim_count;
+    stats.frames += header.frame_count;
+    stats.images += header.image_count;
+}
+
+void CountSpriteRecords(ConversionStats &stats, const SpriteProject &project)
+{
+    stats.sprites += project.sprite_list.size();
+    stats.anims += project.anim_list.size();
+    for (size_t i = 0; i < project.anim_list.size(); i++) {
+        stats.frames += project.anim_list[i].size();
+    }
+    for (size_t i = 0; i < project.sprite_list.size(); i++) {
+        stats.images += project.sprite_list[i].images.size();
+    }
+}
+
+bool VerifySpriteFile(ConversionContext &context, const uint8_t *data, size_t size, SpriteHeader &header)
+{
+    PhaseScope scope(context, PHASE_VERIFY);
+    //Read and verify sprite header
+    if (size < 0x18) {
+        return SetError(context, "Invalid sprite file.");
+    }
+    ReadSpriteHeader(data, header);
+    if (!VerifySpriteHeader(header, size)) {
+        return SetError(context, "Invalid sprite file.");
+    }
+    //Check if any frame or image range exceeds end of file
+    for (uint16_t i = 0; i < header.anim_count; i++) {
+        const uint8_t *src = &data[header.anim_ofs + (i * 4)];
+        if (header.frame_ofs + ((uint64_t)ReadU16(&src[0]) + ReadU16(&src[2])) * 28 > size) {
+            return SetError(context, "Invalid sprite file.");
+        }
+    }
+    for (uint16_t i = 0; i < header.sprite_count; i++) {
+        const uint8_t *src = &data[header.sprite_ofs + (i * 12)];
+        if (header.image_ofs + ((uint64_t)ReadU16(&src[0]) + ReadU16(&src[2])) * 28 > size) {
+            return SetError(context, "Invalid sprite file.");
+        }
+    }
+    return true;
+}
+
+void PrintSpriteFileRange(tinyxml2::XMLPrinter &printer, const uint8_t *data, SpriteHeader &header, size_t first, size_t last)
+{
+    //Elements are numbered with animations first followed by sprites
+    char name_buf[16];
+    for (size_t i = first; i < last; i++) {
+        if (i < header.anim_count) {
+            const uint8_t *src = &data[header.anim_ofs + (i * 4)];
+            uint16_t start_frame = ReadU16(&src[0]);
+            uint16_t num_frames = ReadU16(&src[2]);
+            printer.OpenElement("anim");
+            const uint8_t *frame_data = &data[header.frame_ofs + (start_frame * 28)];
+            for (uint16_t j = 0; j < num_frames; j++) {
+                AnimFrame frame;
+                ReadAnimFrame(&frame_data[j * 28], frame);
+                //Sprites are named after their index so no sprite list is needed
+                GetIndexedSpriteName(frame.sprite_idx, name_buf, sizeof(name_buf));
+                PrintAnimFrame(printer, frame, name_buf);
+            }
+            printer.CloseElement();
+        } else {
+            uint16_t sprite_idx = i - header.anim_count;
+            const uint8_t *src = &data[header.sprite_ofs + (sprite_idx * 12)];
+            uint16_t start_image = ReadU16(&src[0]);
+            uint16_t num_images = ReadU16(&src[2]);
+            printer.OpenElement("sprite");
+            GetIndexedSpriteName(sprite_idx, name_buf, sizeof(name_buf));
+            printer.PushAttribute("name", name_buf);
+            const uint8_t *image_data = &data[header.image_ofs + (start_image * 28)];
+            for (uint16_t j = 0; j < num_images; j++) {
+                Image image;
+                ReadImage(&image_data[j * 28], image);
+                PrintImage(printer, image);
+            }
+            printer.CloseElement();
+        }
+    }
+}
+
+//Smallest number of frames and images worth printing on another thread
+const size_t MIN_XML_RANGE_RECORDS = 4096;
+
+void SplitSpriteFileRanges(const uint8_t *data, SpriteHeader &header, unsigned num_threads, std::vector<size_t> &range_starts)
+{
+    //Weigh elements by number of records they print
+    size_t num_elements = header.anim_count + header.sprite_count;
+    std::vector<size_t> weights(num_elements);
+    size_t total_weight = 0;
+    for (size_t i = 0; i < num_elements; i++) {
+        if (i < header.anim_count) {
+            weights[i] = 1 + ReadU16(&data[header.anim_ofs + (i * 4) + 2]);
+        } else {
+            weights[i] = 1 + ReadU16(&data[header.sprite_ofs + ((i - header.anim_count) * 12) + 2]);
+        }
+        total_weight += weights[i];
+    }
+    size_t num_ranges = std::max<size_t>(1, std::min<size_t>(num_threads * 4, total_weight / MIN_XML_RANGE_RECORDS));
+    //Start new range whenever enough weight has been added to current one
+    range_starts.assign(1, 0);
+    size_t weight = 0;
+    for (size_t i = 0; i < num_elements; i++) {
+        if (weight >= total_weight * range_starts.size() / num_ranges && i != range_starts.back()) {
+            range_starts.push_back(i);
+        }
+        weight += weights[i];
+    }
+}
+
+bool PrintSpriteFileXML(ConversionContext &context, const uint8_t *data, size_t size, std::deque<tinyxml2::XMLPrinter> &printers, std::vector<std::string_view> &parts)
+{
+    SpriteHeader header;
+    if (!VerifySpriteFile(context, data, size, header)) {
+        return false;
+    }
+    CountSpriteRecords(context.stats, header);
+    PhaseScope scope(context, PHASE_PRINT);
+    size_t num_elements = header.anim_count + header.sprite_count;
+    if (num_elements == 0) {
+        parts.push_back("<spritedata/>\n");
+        return true;
+    }
+    std::vector<size_t> range_starts;
+    SplitSpriteFileRanges(data, header, context.num_threads, range_starts);
+    range_starts.push_back(num_elements);
+    //Print ranges of root children at their indentation in the document
+    for (size_t i = 0; i + 1 < range_starts.size(); i++) {
+        printers.emplace_back(nullptr, false, 1);
+    }
+    ParallelFor(printers.size(), context.num_threads, [&](size_t i) {
+        TraceScope scope(context.trace, "print_range", "chunk");
+        PrintSpriteFileRange(printers[i], data, header, range_starts[i], range_starts[i + 1]);
+    });
+    //Printer puts a line break before every child except the first it prints
+    parts.push_back("<spritedata>");
+    for (size_t i = 0; i < printers.size(); i++) {
+        parts.push_back("\n");
+        parts.emplace_back(printers[i].CStr(), printers[i].CStrSize() - 1);
+    }
+    parts.push_back("\n</spritedata>\n");
+    return true;
+}
+
+void PushJSONInt(std::string &out, const char *name, int value)
+{
+    out += ", ";
+    WriteJSONKey(out, name);
+    WriteJSONInt(out, value);
+}
+
+void PushJSONFloat(std::string &out, const char *name, float value)
+{
+    out += ", ";
+    WriteJSONKey(out, name);
+    WriteJSONFloat(out, value);
+}
+
+void PushJSONString(std::string &out, const char *name, const char *value)
+{
+    out += ", ";
+    WriteJSONKey(out, name);
+    WriteJSONString(out, value);
+}
+
+void PrintJSONFrame(std::string &out, const AnimFrame &frame, const char *sprite_name)
+{
+    out += '{';
+    WriteJSONKey(out, GetFrameAttributeName(FRAME_ATTR_SPRITE));
+    WriteJSONString(out, sprite_name);
+    //Omit the same defaults as XML
+    if (frame.delay != 1) {
+        PushJSONInt(out, GetFrameAttributeName(FRAME_ATTR_DELAY), frame.delay);
+    }
+    if (frame.max_delay != 0) {
+        PushJSONInt(out, GetFrameAttributeName(FRAME_ATTR_MAX_DELAY), frame.max_delay);
+    }
+    if (frame.x_scale != 1.0f) {
+        PushJSONFloat(out, GetFrameAttributeName(FRAME_ATTR_X_SCALE), frame.x_scale);
+    }
+    if (frame.y_scale != 1.0f) {
+        PushJSONFloat(out, GetFrameAttributeName(FRAME_ATTR_Y_SCALE), frame.y_scale);
+    }
+    if (frame.x != 0.0f || std::signbit(frame.x)) {
+        PushJSONFloat(out, GetFrameAttributeName(FRAME_ATTR_X), frame.x);
+    }
+    if (frame.y != 0.0f || std::signbit(frame.y)) {
+        PushJSONFloat(out, GetFrameAttributeName(FRAME_ATTR_Y), frame.y);
+    }
+    if (frame.angle != 0) {
+        PushJSONInt(out, GetFrameAttributeName(FRAME_ATTR_ANGLE), frame.angle);
+    }
+    out += '}';
+}
+
+void PrintJSONImage(std::string &out, const Image &image)
+{
+    out += '{';
+    WriteJSONKey(out, GetImageAttributeName(IMAGE_ATTR_TEXTURE_ID));
+    WriteJSONInt(out, image.texture_id);
+    //Omit the same defaults as XML
+    if (image.num_palettes > 1) {
+        PushJSONInt(out, GetImageAttributeName(IMAGE_ATTR_NUM_PALETTES), image.num_palettes);
+    }
+    PushJSONInt(out, GetImageAttributeName(IMAGE_ATTR_SRC_X), image.src_x);
+    PushJSONInt(out, GetImageAttributeName(IMAGE_ATTR_SRC_Y), image.src_y);
+    PushJSONInt(out, GetImageAttributeName(IMAGE_ATTR_X), image.x);
+    PushJSONInt(out, GetImageAttributeName(IMAGE_ATTR_Y), image.y);
+    PushJSONInt(out, GetImageAttributeName(IMAGE_ATTR_W), image.w);
+    PushJSONInt(out, GetImageAttributeName(IMAGE_ATTR_H), image.h);
+    if (image.alpha_mode != 0) {
+        PushJSONFloat(out, GetImageAttributeName(IMAGE_ATTR_ALPHA), GetImageAlpha(image.alpha_mode));
+    }
+    if (image.angle != 0) {
+        PushJSONInt(out, GetImageAttributeName(IMAGE_ATTR_ANGLE), image.angle);
+    }
+    if (image.blend_mode != 0) {
+        PushJSONString(out, GetImageAttributeName(IMAGE_ATTR_BLEND_MODE), GetBlendModeName(image.blend_mode));
+    }
+    if (image.bilinear) {
+        out += ", ";
+        WriteJSONKey(out, GetImageAttributeName(IMAGE_ATTR_BILINEAR));
+        out += "true";
+    }
+    if (image.flip & 0x1) {
+        out += ", ";
+        WriteJSONKey(out, GetImageAttributeName(IMAGE_ATTR_FLIP_X));
+        out += "true";
+    }
+    if (image.flip & 0x2) {
+        out += ", ";
+        WriteJSONKey(out, GetImageAttributeName(IMAGE_ATTR_FLIP_Y));
+        out += "true";
+    }
+    out += '}';
+}
+
+//Frames and images are written one per line inside their animation or sprite
+void OpenJSONAnim(std::string &out)
+{
+    out += "        {";
+    WriteJSONKey(out, "frames");
+    out += '[';
+}
+
+void OpenJSONSprite(std::string &out, const char *name)
+{
+    out += "        {";
+    WriteJSONKey(out, "name");
+    WriteJSONString(out, name);
+    out += ", ";
+    WriteJSONKey(out, "images");
+    out += '[';
+}
+
+void StartJSONListItem(std::string &out, size_t index)
+{
+    out += (index == 0) ? "\n            " : ",\n            ";
+}
+
+void CloseJSONList(std::string &out, size_t count)
+{
+    if (count != 0) {
+        out += "\n        ";
+    }
+    out += "]}";
+}
+
+bool PrintSpriteJSON(ConversionContext &context, std::string &json)
+{
+    PhaseScope scope(context, PHASE_PRINT);
+    SpriteProject &project = context.project;
+    json = "{\n    \"anims\": [";
+    //Write animation sequences
+    char name_buf[16];
+    for (size_t i = 0; i < project.anim_list.size(); i++) {
+        json += (i == 0) ? "\n" : ",\n";
+        OpenJSONAnim(json);
+        for (size_t j = 0; j < project.anim_list[i].size(); j++) {
+            StartJSONListItem(json, j);
+            uint16_t sprite_idx = project.anim_list[i][j].sprite_idx;
+            if (sprite_idx < project.sprite_list.size()) {
+                PrintJSONFrame(json, project.anim_list[i][j], project.sprite_list[sprite_idx].name.c_str());
+            } else {
+                //Use name derived from index for sprites outside of file
+                GetIndexedSpriteName(sprite_idx, name_buf, sizeof(name_buf));
+                PrintJSONFrame(json, project.anim_list[i][j], name_buf);
+            }
+        }
+        CloseJSONList(json, project.anim_list[i].size());
+    }
+    json += project.anim_list.empty() ? "],\n    \"sprites\": [" : "\n    ],\n    \"sprites\": [";
+    //Write sprites
+    for (size_t i = 0; i < project.sprite_list.size(); i++) {
+        json += (i == 0) ? "\n" : ",\n";
+        OpenJSONSprite(json, project.sprite_list[i].name.c_str());
+        for (size_t j = 0; j < project.sprite_list[i].images.size(); j++) {
+            StartJSONListItem(json, j);
+            PrintJSONImage(json, project.sprite_list[i].images[j]);
+        }
+        CloseJSONList(json, project.sprite_list[i].images.size());
+    }
+    json += project.sprite_list.empty() ? "]\n}\n" : "\n    ]\n}\n";
+    return true;
+}
+
+void PrintSpriteFileJSONRange(std::string &out, const uint8_t *data, SpriteHeader &header, size_t first, size_t last)
+{
+    //Elements are numbered with animations first followed by sprites
+    char name_buf[16];
+    for (size_t i = first; i < last; i++) {
+        if (i != first) {
+            out += ",\n";
+        }
+        if (i < header.anim_count) {
+            const uint8_t *src = &data[header.anim_ofs + (i * 4)];
+            uint16_t start_frame = ReadU16(&src[0]);
+            uint16_t num_frames = ReadU16(&src[2]);
+            OpenJSONAnim(out);
+            const uint8_t *frame_data = &data[header.frame_ofs + (start_frame * 28)];
+            for (uint16_t j = 0; j < num_frames; j++) {
+                AnimFrame frame;
+                ReadAnimFrame(&frame_data[j * 28], frame);
+                StartJSONListItem(out, j);
+                GetIndexedSpriteName(frame.sprite_idx, name_buf, sizeof(name_buf));
+                PrintJSONFrame(out, frame, name_buf);
+            }
+            CloseJSONList(out, num_frames);
+        } else {
+            uint16_t sprite_idx = i - header.anim_count;
+            const uint8_t *src = &data[header.sprite_ofs + (sprite_idx * 12)];
+            uint16_t start_image = ReadU16(&src[0]);
+            uint16_t num_images = ReadU16(&src[2]);
+            GetIndexedSpriteName(sprite_idx, name_buf, sizeof(name_buf));
+            OpenJSONSprite(out, name_buf);
+            const uint8_t *image_data = &data[header.image_ofs + (start_image * 28)];
+            for (uint16_t j = 0; j < num_images; j++) {
+                Image image;
+                ReadImage(&image_data[j * 28], image);
+                StartJSONListItem(out, j);
+                PrintJSONImage(out, image);
+            }
+            CloseJSONList(out, num_images);
+        }
+    }
+}
+
+bool PrintSpriteFileJSON(ConversionContext &context, const uint8_t *data, size_t size, std::vector<std::string> &ranges, std::vector<std::string_view> &parts)
+{
+    SpriteHeader header;
+    if (!VerifySpriteFile(context, data, size, header)) {
+        return false;
+    }
+    CountSpriteRecords(context.stats, header);
+    PhaseScope scope(context, PHASE_PRINT);
+    size_t num_elements = header.anim_count + header.sprite_count;
+    std::vector<size_t> range_starts;
+    SplitSpriteFileRanges(data, header, context.num_threads, range_starts);
+    //Keep animations and sprites in separate ranges since they go in separate arrays
+    if (header.anim_count != 0 && header.anim_count != num_elements && !std::binary_search(range_starts.begin(), range_starts.end(), header.anim_count)) {
+        range_starts.insert(std::upper_bound(range_starts.begin(), range_starts.end(), header.anim_count), header.anim_count);
+    }
+    range_starts.push_back(num_elements);
+    if (num_elements != 0) {
+        ranges.resize(range_starts.size() - 1);
+    }
+    ParallelFor(ranges.size(), context.num_threads, [&](size_t i) {
+        TraceScope scope(context.trace, "print_range", "chunk");
+        PrintSpriteFileJSONRange(ranges[i], data, header, range_starts[i], range_starts[i + 1]);
+    });
+    //Join ranges inside the array their elements belong to
+    parts.push_back("{\n    \"anims\": [");
+    size_t i = 0;
+    for (; i < ranges.size() && range_starts[i] < header.anim_count; i++) {
+        parts.push_back((i == 0) ? "\n" : ",\n");
+        parts.push_back(ranges[i]);
+    }
+    parts.push_back((header.anim_count == 0) ? "],\n    \"sprites\": [" : "\n    ],\n    \"sprites\": [");
+    for (size_t first = i; i < ranges.size(); i++) {
+        parts.push_back((i == first) ? "\n" : ",\n");
+        parts.push_back(ranges[i]);
+    }
+    parts.push_back((header.sprite_count == 0) ? "]\n}\n" : "\n    ]\n}\n");
+    return true;
+}
+
+bool FindXMLAttribute(XMLReader &reader, const char *name, std::string_view &value)
+{
+    for (size_t i = 0; i < reader.attributes.size(); i++) {
+        if (reader.attributes[i].name == name) {
+            //Write value if found
+            value = reader.attributes[i].value;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string_view TrimXMLValue(std::string_view text)
+{
+    //Ignore whitespace around values like sscanf did
+    while (!text.empty() && IsXMLSpace(text.front())) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && IsXMLSpace(text.back())) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+bool ParseXMLUnsigned(std::string_view text, uint32_t max_value, uint32_t &value)
+{
+    text = TrimXMLValue(text);
+    int base = 10;
+    if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+        //Read hexadecimal value
+        text.remove_prefix(2);
+        base = 16;
+    } else if (!text.empty() && text[0] == '+') {
+        text.remove_prefix(1);
+    }
+    uint32_t temp;
+    std::from_chars_result result = std::from_chars(text.data(), text.data() + text.size(), temp, base);
+    //Fail on trailing characters and values too large for destination
+    if (result.ec != std::errc() || result.ptr != text.data() + text.size() || temp > max_value) {
+        return false;
+    }
+    value = temp;
+    return true;
+}
+
+bool ParseXMLSigned(std::string_view text, int32_t min_value, int32_t max_value, int32_t &value)
+{
+    text = TrimXMLValue(text);
+    if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+        //Hexadecimal values are never negative
+        uint32_t temp;
+        if (!ParseXMLUnsigned(text, (uint32_t)max_value, temp)) {
+            return false;
+        }
+        value = temp;
+        return true;
+    }
+    if (text.size() > 1 && text[0] == '+' && text[1] != '-') {
+        text.remove_prefix(1);
+    }
+    int32_t temp;
+    std::from_chars_result result = std::from_chars(text.data(), text.data() + text.size(), temp);
+    //Fail on trailing characters and values outside of destination range
+    if (result.ec != std::errc() || result.ptr != text.data() + text.size() || temp < min_value || temp > max_value) {
+        return false;
+    }
+    value = temp;
+    return true;
+}
+
+bool ParseXMLFloat(std::string_view text, float &value)
+{
+    text = TrimXMLValue(text);
+    if (text.size() > 1 && text[0] == '+' && text[1] != '-') {
+        text.remove_prefix(1);
+    }
+    float temp;
+    std::from_chars_result result = std::from_chars(text.data(), text.data() + text.size(), temp);
+    if (result.ec != std::errc() || result.ptr != text.data() + text.size()) {
+        return false;
+    }
+    value = temp;
+    return true;
+}
+
+bool ParseXMLBool(std::string_view text, bool &value)
+{
+    text = TrimXMLValue(text);
+    //Accept any integer like tinyxml2
+    int32_t temp;
+    if (ParseXMLSigned(text, INT32_MIN, INT32_MAX, temp)) {
+        value = (temp != 0);
+        return true;
+    }
+    if (text == "true" || text == "True" || text == "TRUE") {
+        value = true;
+        return true;
+    }
+    if (text == "false" || text == "False" || text == "FALSE") {
+        value = false;
+        return true;
+    }
+    return false;
+}
+
+bool ParseXMLU8(std::string_view text, uint8_t &value)
+{
+    uint32_t temp;
+    if (!ParseXMLUnsigned(text, UINT8_MAX, temp)) {
+        return false;
+    }
+    value = temp;
+    return true;
+}
+
+bool ParseXMLU16(std::string_view text, uint16_t &value)
+{
+    uint32_t temp;
+    if (!ParseXMLUnsigned(text, UINT16_MAX, temp)) {
+        return false;
+    }
+    value = temp;
+    return true;
+}
+
+bool ParseXMLS16(std::string_view text, int16_t &value)
+{
+    int32_t temp;
+    if (!ParseXMLSigned(text, INT16_MIN, INT16_MAX, temp)) {
+        return false;
+    }
+    value = temp;
+    return true;
+}
+
+tinyxml2::XMLError QueryAttributeString(XMLReader &reader, const char *name, std::string_view *value)
+{
+    if (!FindXMLAttribute(reader, name, *value)) {
+        return tinyxml2::XML_NO_ATTRIBUTE;
+    }
+    return tinyxml2::XML_SUCCESS;
+}
+
+//Element being parsed from XML or JSON text, used to locate errors
+struct SourceElement {
+    std::string_view name;
+    const char *start; //Start of text
+    const char *pos; //Current position in text
+};
+
+SourceElement GetXMLElement(XMLReader &reader)
+{
+    return { reader.name, reader.start, reader.pos };
+}
+
+std::string GetSourceLocation(const SourceElement &element)
+{
+    //Count lines only when a message needs them
+    return "Line " + std::to_string(std::count(element.start, element.pos, '\n') + 1) + ": ";
+}
+
+bool RequireAttribute(ConversionContext &context, const SourceElement &element, const char *name, tinyxml2::XMLError error)
+{
+    if (error == tinyxml2::XML_SUCCESS) {
+        return true;
+    }
+    if (error == tinyxml2::XML_NO_ATTRIBUTE) {
+        //Fail if attribute is missing
+        return SetError(context, GetSourceLocation(element) + "Element " + std::string(element.name) + " has no attribute " + name + ".");
+    }
+    //Fail if attribute could not be converted
+    return SetError(context, GetSourceLocation(element) + "Attribute " + name + " of element " + std::string(element.name) + " is invalid.");
+}
+
+//Slots of attribute lookup table, must be a power of 2
+const size_t ATTRIBUTE_TABLE_SIZE = 32;
+
+struct AttributeTable {
+    const AttributeSchema *schema;
+    int8_t slots[ATTRIBUTE_TABLE_SIZE]; //Index into schema, -1 if empty
+};
+
+size_t HashAttributeName(std::string_view name)
+{
+    if (name.empty()) {
+        return 0;
+    }
+    //Multipliers chosen so that no known attribute names collide
+    return (name.size() + ((uint8_t)name.front() * 8) + ((uint8_t)name.back() * 23)) & (ATTRIBUTE_TABLE_SIZE - 1);
+}
+
+AttributeTable CreateAttributeTable(const AttributeSchema *schema, size_t count)
+{
+    AttributeTable table;
+    table.schema = schema;
+    memset(table.slots, -1, sizeof(table.slots));
+    for (size_t i = 0; i < count; i++) {
+        //Probe for free slot in case new names collide
+        size_t slot = HashAttributeName(schema[i].name);
+        while (table.slots[slot] >= 0) {
+            slot = (slot + 1) & (ATTRIBUTE_TABLE_SIZE - 1);
+        }
+        table.slots[slot] = i;
+    }
+    return table;
+}
+
+int FindAttributeID(const AttributeTable &table, std::string_view name)
+{
+    size_t slot = HashAttributeName(name);
+    while (table.slots[slot] >= 0) {
+        const AttributeSchema &entry = table.schema[table.slots[slot]];
+        if (name == entry.name) {
+            return entry.id;
+        }
+        slot = (slot + 1) & (ATTRIBUTE_TABLE_SIZE - 1);
+    }
+    //Attribute is not in schema
+    return -1;
+}
+
+void WarnUnknownAttribute(ConversionContext &context, const SourceElement &element, std::string_view name)
+{
+    //Warn once per element and attribute name
+    std::string key = "Unknown attribute " + std::string(name) + " of element " + std::string(element.name) + " ignored.";
+    if (context.warned_attributes.insert(key).second) {
+        context.warnings.push_back(GetSourceLocation(element) + key);
+    }
+}
+
+bool MarkAttributeFound(ConversionContext &context, const SourceElement &element, const AttributeSchema *schema, int id, uint32_t &found)
+{
+    if (found & (1 << id)) {
+        //Fail if attribute or its alias appears twice
+        return SetError(context, GetSourceLocation(element) + "Attribute " + schema[id].name + " of element " + std::string(element.name) + " is repeated.");
+    }
+    found |= 1 << id;
+    return true;
+}
+
+bool CheckRequiredAttributes(ConversionContext &context, const SourceElement &element, const AttributeSchema *schema, size_t count, uint32_t found)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (schema[i].required && !(found & (1 << i))) {
+            return RequireAttribute(context, element, schema[i].name, tinyxml2::XML_NO_ATTRIBUTE);
+        }
+    }
+    return true;
+}
+
+void SetImageDefaults(Image &image)
+{
+    //Set defaults of optional attributes
+    image.num_palettes = 1; //Always have base palette
+    image.alpha_mode = 0; //Image is opaque
+    image.angle = 0;
+    image.blend_mode = 0; //Use normal blend mode by default
+    image.bilinear = false;
+    image.flip = 0; //No flip by default
+}
+
+bool SetImageAttribute(Image &image, int id, std::string_view value)
+{
+    float alpha_value;
+    bool flip;
+    switch (id) {
+        case IMAGE_ATTR_TEXTURE_ID:
+            return ParseXMLU16(value, image.texture_id);
+        case IMAGE_ATTR_NUM_PALETTES:
+            return ParseXMLU16(value, image.num_palettes);
+        case IMAGE_ATTR_SRC_X:
+            return ParseXMLU16(value, image.src_x);
+        case IMAGE_ATTR_SRC_Y:
+            return ParseXMLU16(value, image.src_y);
+        case IMAGE_ATTR_X:
+            return ParseXMLS16(value, image.x);
+        case IMAGE_ATTR_Y:
+            return ParseXMLS16(value, image.y);
+        case IMAGE_ATTR_W:
+            return ParseXMLU16(value, image.w);
+        case IMAGE_ATTR_H:
+            return ParseXMLU16(value, image.h);
+        case IMAGE_ATTR_ALPHA:
+            if (!ParseXMLFloat(value, alpha_value)) {
+                return false;
+            }
+            image.alpha_mode = GetAlphaModeValue(alpha_value);
+            return true;
+        case IMAGE_ATTR_ANGLE:
+            return ParseXMLS16(value, image.angle);
+        case IMAGE_ATTR_BLEND_MODE:
+            image.blend_mode = GetBlendModeValue(value);
+            return true;
+        case IMAGE_ATTR_BILINEAR:
+            return ParseXMLBool(value, image.bilinear);
+        case IMAGE_ATTR_FLIP_X:
+            if (!ParseXMLBool(value, flip)) {
+                return false;
+            }
+            if (flip) {
+                image.flip |= 0x1;
+            }
+            return true;
+        case IMAGE_ATTR_FLIP_Y:
+            if (!ParseXMLBool(value, flip)) {
+                return false;
+            }
+            if (flip) {
+                image.flip |= 0x2;
+            }
+            return true;
+    }
+    return true;
+}
+
+void SetFrameDefaults(AnimFrame &frame)
+{
+    //Set defaults of optional attributes
+    frame.sprite_idx = 0; //Resolved after parsing
+    frame.delay = 1;
+    frame.max_delay = 0;
+    frame.x_scale = frame.y_scale = 1.0f;
+    frame.x = frame.y = 0.0f;
+    frame.angle = 0;
+}
+
+bool SetFrameAttribute(ConversionContext &context, AnimFrame &frame, int id, std::string_view value)
+{
+    switch (id) {
+        case FRAME_ATTR_SPRITE:
+            context.frame_sprite_names.emplace_back(value);
+            return true;
+        case FRAME_ATTR_DELAY:
+            return ParseXMLU8(value, frame.delay);
+        case FRAME_ATTR_MAX_DELAY:
+            return ParseXMLU8(value, frame.max_delay);
+        case FRAME_ATTR_X_SCALE:
+            return ParseXMLFloat(value, frame.x_scale);
+        case FRAME_ATTR_Y_SCALE:
+            return ParseXMLFloat(value, frame.y_scale);
+        case FRAME_ATTR_X:
+            return ParseXMLFloat(value, frame.x);
+        case FRAME_ATTR_Y:
+            return ParseXMLFloat(value, frame.y);
+        case FRAME_ATTR_ANGLE:
+            return ParseXMLS16(value, frame.angle);
+    }
+    return true;
+}
+
+const AttributeTable &GetImageAttributeTable()
+{
+    static const AttributeTable table = CreateAttributeTable(image_schema, sizeof(image_schema) / sizeof(image_schema[0]));
+    return table;
+}
+
+const AttributeTable &GetFrameAttributeTable()
+{
+    static const AttributeTable table = CreateAttributeTable(frame_schema, sizeof(frame_schema) / sizeof(frame_schema[0]));
+    return table;
+}
+
+bool ParseImage(ConversionContext &context, XMLReader &reader, Image &image)
+{
+    const AttributeTable &table = GetImageAttributeTable();
+    SourceElement element = GetXMLElement(reader);
+    SetImageDefaults(image);
+    //Dispatch each attribute to its field in one pass
+    uint32_t found = 0;
+    for (size_t i = 0; i < reader.attributes.size(); i++) {
+        const XMLReaderAttribute &attribute = reader.attributes[i];
+        int id = FindAttributeID(table, attribute.name);
+        if (id < 0) {
+            WarnUnknownAttribute(context, element, attribute.name);
+            continue;
+        }
+        if (!MarkAttributeFound(context, element, image_schema, id, found)) {
+            return false;
+        }
+        if (!SetImageAttribute(image, id, attribute.value)) {
+            return RequireAttribute(context, element, image_schema[id].name, tinyxml2::XML_WRONG_ATTRIBUTE_TYPE);
+        }
+    }
+    return CheckRequiredAttributes(context, element, image_schema, IMAGE_ATTR_COUNT, found);
+}
+
+bool ParseFrame(ConversionContext &context, XMLReader &reader, AnimFrame &frame)
+{
+    const AttributeTable &table = GetFrameAttributeTable();
+    SourceElement element = GetXMLElement(reader);
+    SetFrameDefaults(frame);
+    //Dispatch each attribute to its field in one pass
+    uint32_t found = 0;
+    for (size_t i = 0; i < reader.attributes.size(); i++) {
+        const XMLReaderAttribute &attribute = reader.attributes[i];
+        int id = FindAttributeID(table, attribute.name);
+        if (id < 0) {
+            WarnUnknownAttribute(context, element, attribute.name);
+            continue;
+        }
+        if (!MarkAttributeFound(context, element, frame_schema, id, found)) {
+            return false;
+        }
+        if (!SetFrameAttribute(context, frame, id, attribute.value)) {
+            return RequireAttribute(context, element, frame_schema[id].name, tinyxml2::XML_WRONG_ATTRIBUTE_TYPE);
+        }
+    }
+    return CheckRequiredAttributes(context, element, frame_schema, FRAME_ATTR_COUNT, found);
+}
+
+bool ParseSprite(ConversionContext &context, XMLReader &reader)
+{
+    //Add sprite to list and fill it in place
+    context.project.sprite_list.emplace_back();
+    Sprite &sprite = context.project.sprite_list.back();
+    //Query sprite name
+    std::string_view sprite_name;
+    if (!RequireAttribute(context, GetXMLElement(reader), "name", QueryAttributeString(reader, "name", &sprite_name))) {
+        return false;
+    }
+    sprite.name = sprite_name;
+    sprite.min_x = sprite.min_y = sprite.max_x = sprite.max_y = 0; //Zero out sprite rectangle
+    //Read image elements until sprite ends
+    while (true) {
+        XMLEventType event = ReadXMLEvent(reader);
+        if (event == XML_EVENT_END) {
+            return true;
+        }
+        if (event != XML_EVENT_START) {
+            return SetError(context, reader.error);
+        }
+        if (reader.name == "image") {
+            sprite.images.emplace_back();
+            if (!ParseImage(context, reader, sprite.images.back())) {
+                return false;
+            }
+        }
+        //Skip contents of child element
+        if (!SkipXMLElement(reader)) {
+            return SetError(context, reader.error);
+        }
+    }
+}
+
+bool ParseAnim(ConversionContext &context, XMLReader &reader)
+{
+    //Add animation to list and fill it in place
+    context.project.anim_list.emplace_back();
+    std::vector<AnimFrame> &anim = context.project.anim_list.back();
+    //Read frame elements until animation ends
+    while (true) {
+        XMLEventType event = ReadXMLEvent(reader);
+        if (event == XML_EVENT_END) {
+            return true;
+        }
+        if (event != XML_EVENT_START) {
+            return SetError(context, reader.error);
+        }
+        if (reader.name == "frame") {
+            anim.emplace_back();
+            if (!ParseFrame(context, reader, anim.back())) {
+                return false;
+            }
+        }
+        //Skip contents of child element
+        if (!SkipXMLElement(reader)) {
+            return SetError(context, reader.error);
+        }
+    }
+}
+
+bool ParseSpriteData(ConversionContext &context, XMLReader &reader, const char *limit)
+{
+    //Read sprite and animation elements until root ends
+    while (true) {
+        XMLEventType event = ReadXMLEvent(reader);
+        if (event == XML_EVENT_END) {
+            return true;
+        }
+        if (event != XML_EVENT_START) {
+            return SetError(context, reader.error);
+        }
+        if (reader.tag_start >= limit) {
+            //Leave elements starting at limit to next chunk
+            return true;
+        }
+        if (reader.name == "sprite") {
+            if (!ParseSprite(context, reader)) {
+                return false;
+            }
+        } else if (reader.name == "anim") {
+            if (!ParseAnim(context, reader)) {
+                return false;
+            }
+        } else if (!SkipXMLElement(reader)) {
+            //Fail if unknown element is malformed
+            return SetError(context, reader.error);
+        }
+    }
+}
+
+//Smallest amount of XML text worth parsing on another thread
+const size_t MIN_XML_CHUNK_SIZE = 256 * 1024;
+
+struct XMLChunk {
+    const char *start; //Position in root element to start parsing from
+    const char *limit; //Elements starting at or after this are left to next chunk
+    const char *stop; //Start of first element left to next chunk, null if root ended
+    const char *root_end; //Position after end of root if it ended in this chunk
+    ConversionContext context; //Sprites, animations, and warnings of chunk
+    bool success;
+};
+
+const char *FindXMLChunkStart(const char *pos, const char *end)
+{
+    //Guess next start of sprite or animation element
+    while ((pos = (const char *)memchr(pos, '<', end - pos)) != nullptr) {
+        pos++;
+        std::string_view rest(pos, end - pos);
+        size_t name_len = 0;
+        if (rest.substr(0, 6) == "sprite") {
+            name_len = 6;
+        } else if (rest.substr(0, 4) == "anim") {
+            name_len = 4;
+        }
+        if (name_len != 0 && rest.size() > name_len && (IsXMLSpace(rest[name_len]) || rest[name_len] == '>' || rest[name_len] == '/')) {
+            return pos - 1;
+        }
+    }
+    return nullptr;
+}
+
+void ParseXMLChunk(const char *xml, size_t size, XMLChunk &chunk)
+{
+    //Read chunk as if root element was already open
+    XMLReader reader;
+    InitXMLReader(reader, xml, size);
+    reader.pos = chunk.start;
+    reader.open_elements.push_back("spritedata");
+    chunk.success = ParseSpriteData(chunk.context, reader, chunk.limit);
+    if (reader.open_elements.empty()) {
+        chunk.stop = nullptr;
+        chunk.root_end = reader.pos;
+    } else {
+        chunk.stop = reader.tag_start;
+        chunk.root_end = nullptr;
+    }
+}
+
+void MergeXMLChunk(ConversionContext &context, ConversionContext &chunk)
+{
+    SpriteProject &project = context.project;
+    std::move(chunk.project.sprite_list.begin(), chunk.project.sprite_list.end(), std::back_inserter(project.sprite_list));
+    std::move(chunk.project.anim_list.begin(), chunk.project.anim_list.end(), std::back_inserter(project.anim_list));
+    std::move(chunk.frame_sprite_names.begin(), chunk.frame_sprite_names.end(), std::back_inserter(context.frame_sprite_names));
+    for (size_t i = 0; i < chunk.warnings.size(); i++) {
+        //Drop warnings earlier chunks already gave without location
+        std::string message = chunk.warnings[i].substr(chunk.warnings[i].find(": ") + 2);
+        if (context.warned_attributes.insert(message).second) {
+            context.warnings.push_back(chunk.warnings[i]);
+        }
+    }
+}
+
+bool ParseSpriteDataParallel(ConversionContext &context, XMLReader &reader, const char *xml, size_t size)
+{
+    size_t num_chunks = std::min<size_t>(context.num_threads * 4, (reader.end - reader.pos) / MIN_XML_CHUNK_SIZE);
+    if (reader.pending_end || context.num_threads <= 1 || num_chunks <= 1) {
+        return ParseSpriteData(context, reader, reader.end);
+    }
+    //Split root contents at guessed element starts
+    std::vector<XMLChunk> chunks(1);
+    chunks[0].start = reader.pos;
+    for (size_t i = 1; i < num_chunks; i++) {
+        const char *target = reader.pos + (reader.end - reader.pos) * i / num_chunks;
+        const char *start = FindXMLChunkStart(std::max(target, chunks.back().start + 1), reader.end);
+        if (!start) {
+            break;
+        }
+        chunks.emplace_back();
+        chunks.back().start = start;
+    }
+    for (size_t i = 0; i < chunks.size(); i++) {
+        chunks[i].limit = (i + 1 < chunks.size()) ? chunks[i + 1].start : reader.end;
+    }
+    ParallelFor(chunks.size(), context.num_threads, [&](size_t i) {
+        TraceScope scope(context.trace, "parse_chunk", "chunk");
+        ParseXMLChunk(xml, size, chunks[i]);
+    });
+    //Merge chunks in document order
+    const char *next = chunks[0].start;
+    for (size_t i = 0; i < chunks.size(); i++) {
+        if (chunks[i].start != next) {
+            //Guess was not an element boundary so parse again from where previous chunk stopped
+            chunks[i].start = next;
+            chunks[i].context = ConversionContext();
+            TraceScope scope(context.trace, "reparse_chunk", "chunk");
+            ParseXMLChunk(xml, size, chunks[i]);
+        }
+        MergeXMLChunk(context, chunks[i].context);
+        if (!chunks[i].success) {
+            return SetError(context, chunks[i].context.error);
+        }
+        if (!chunks[i].stop) {
+            //Continue reading after root like a sequential parse
+            reader.pos = chunks[i].root_end;
+            reader.open_elements.clear();
+            return true;
+        }
+        next = chunks[i].stop;
+    }
+    //Last chunk always reads to end of root or fails
+    return SetError(context, "Element spritedata is not closed.");
+}
+
+SourceElement GetJSONElement(JSONReader &reader, const char *name)
+{
+    return { name, reader.start, reader.pos };
+}
+
+bool SkipJSONMember(ConversionContext &context, JSONReader &reader)
+{
+    std::string_view text;
+    JSONValueType type = ReadJSONValue(reader, text);
+    if (type == JSON_VALUE_ERROR || !SkipJSONValue(reader, type)) {
+        return SetError(context, reader.error);
+    }
+    return true;
+}
+
+bool ReadJSONContainer(ConversionContext &context, JSONReader &reader, JSONValueType expected, const char *name)
+{
+    std::string_view text;
+    JSONValueType type = ReadJSONValue(reader, text);
+    if (type == JSON_VALUE_ERROR) {
+        return SetError(context, reader.error);
+    }
+    if (type != expected) {
+        const char *type_name = (expected == JSON_VALUE_OBJECT) ? "an object" : "an array";
+        return SetError(context, GetSourceLocation(GetJSONElement(reader, name)) + "Value of " + name + " is not " + type_name + ".");
+    }
+    return true;
+}
+
+bool ReadJSONAttributeValue(ConversionContext &context, JSONReader &reader, std::string_view &value, bool &valid)
+{
+    //Attributes hold numbers, strings, or booleans that are parsed like XML text
+    JSONValueType type = ReadJSONValue(reader, value);
+    if (type == JSON_VALUE_ERROR) {
+        return SetError(context, reader.error);
+    }
+    valid = (type == JSON_VALUE_STRING || type == JSON_VALUE_LITERAL);
+    if (!valid && !SkipJSONValue(reader, type)) {
+        return SetError(context, reader.error);
+    }
+    return true;
+}
+
+bool ParseJSONImage(ConversionContext &context, JSONReader &reader, Image &image)
+{
+    const AttributeTable &table = GetImageAttributeTable();
+    SetImageDefaults(image);
+    //Dispatch each key to its field in one pass
+    uint32_t found = 0;
+    std::string_view key;
+    for (bool first = true; ReadJSONKey(reader, key, first); first = false) {
+        SourceElement element = GetJSONElement(reader, "image");
+        int id = FindAttributeID(table, key);
+        if (id < 0) {
+            WarnUnknownAttribute(context, element, key);
+            if (!SkipJSONMember(context, reader)) {
+                return false;
+            }
+            continue;
+        }
+        if (!MarkAttributeFound(context, element, image_schema, id, found)) {
+            return false;
+        }
+        std::string_view value;
+        bool valid;
+        if (!ReadJSONAttributeValue(context, reader, value, valid)) {
+            return false;
+        }
+        if (!valid || !SetImageAttribute(image, id, value)) {
+            return RequireAttribute(context, element, image_schema[id].name, tinyxml2::XML_WRONG_ATTRIBUTE_TYPE);
+        }
+    }
+    if (!reader.error.empty()) {
+        return SetError(context, reader.error);
+    }
+    return CheckRequiredAttributes(context, GetJSONElement(reader, "image"), image_schema, IMAGE_ATTR_COUNT, found);
+}
+
+bool ParseJSONFrame(ConversionContext &context, JSONReader &reader, AnimFrame &frame)
+{
+    const AttributeTable &table = GetFrameAttributeTable();
+    SetFrameDefaults(frame);
+    //Dispatch each key to its field in one pass
+    uint32_t found = 0;
+    std::string_view key;
+    for (bool first = true; ReadJSONKey(reader, key, first); first = false) {
+        SourceElement element = GetJSONElement(reader, "frame");
+        int id = FindAttributeID(table, key);
+        if (id < 0) {
+            WarnUnknownAttribute(context, element, key);
+            if (!SkipJSONMember(context, reader)) {
+                return false;
+            }
+            continue;
+        }
+        if (!MarkAttributeFound(context, element, frame_schema, id, found)) {
+            return false;
+        }
+        std::string_view value;
+        bool valid;
+        if (!ReadJSONAttributeValue(context, reader, value, valid)) {
+            return false;
+        }
+        if (!valid || !SetFrameAttribute(context, frame, id, value)) {
+            return RequireAttribute(context, element, frame_schema[id].name, tinyxml2::XML_WRONG_ATTRIBUTE_TYPE);
+        }
+    }
+    if (!reader.error.empty()) {
+        return SetError(context, reader.error);
+    }
+    return CheckRequiredAttributes(context, GetJSONElement(reader, "frame"), frame_schema, FRAME_ATTR_COUNT, found);
+}
+
+bool ParseJSONSprite(ConversionContext &context, JSONReader &reader)
+{
+    //Add sprite to list and fill it in place
+    context.project.sprite_list.emplace_back();
+    Sprite &sprite = context.project.sprite_list.back();
+    sprite.min_x = sprite.min_y = sprite.max_x = sprite.max_y = 0; //Zero out sprite rectangle
+    bool found_name = false;
+    std::string_view key;
+    for (bool first = true; ReadJSONKey(reader, key, first); first = false) {
+        if (key == "name") {
+            std::string_view value;
+            bool valid;
+            if (!ReadJSONAttributeValue(context, reader, value, valid)) {
+                return false;
+            }
+            if (!valid) {
+                return RequireAttribute(context, GetJSONElement(reader, "sprite"), "name", tinyxml2::XML_WRONG_ATTRIBUTE_TYPE);
+            }
+            sprite.name = value;
+            found_name = true;
+        } else if (key == "images") {
+            if (!ReadJSONContainer(context, reader, JSON_VALUE_ARRAY, "images")) {
+                return false;
+            }
+            for (bool first_image = true; NextJSONItem(reader, first_image); first_image = false) {
+                if (!ReadJSONContainer(context, reader, JSON_VALUE_OBJECT, "image")) {
+                    return false;
+                }
+                sprite.images.emplace_back();
+                if (!ParseJSONImage(context, reader, sprite.images.back())) {
+                    return false;
+                }
+            }
+            if (!reader.error.empty()) {
+                return SetError(context, reader.error);
+            }
+        } else {
+            WarnUnknownAttribute(context, GetJSONElement(reader, "sprite"), key);
+            if (!SkipJSONMember(context, reader)) {
+                return false;
+            }
+        }
+    }
+    if (!reader.error.empty()) {
+        return SetError(context, reader.error);
+    }
+    if (!found_name) {
+        return RequireAttribute(context, GetJSONElement(reader, "sprite"), "name", tinyxml2::XML_NO_ATTRIBUTE);
+    }
+    return true;
+}
+
+bool ParseJSONAnim(ConversionContext &context, JSONReader &reader)
+{
+    //Add animation to list and fill it in place
+    context.project.anim_list.emplace_back();
+    std::vector<AnimFrame> &anim = context.project.anim_list.back();
+    std::string_view key;
+    for (bool first = true; ReadJSONKey(reader, key, first); first = false) {
+        if (key == "frames") {
+            if (!ReadJSONContainer(context, reader, JSON_VALUE_ARRAY, "frames")) {
+                return false;
+            }
+            for (bool first_frame = true; NextJSONItem(reader, first_frame); first_frame = false) {
+                if (!ReadJSONContainer(context, reader, JSON_VALUE_OBJECT, "frame")) {
+                    return false;
+                }
+                anim.emplace_back();
+                if (!ParseJSONFrame(context, reader, anim.back())) {
+                    return false;
+                }
+            }
+            if (!reader.error.empty()) {
+                return SetError(context, reader.error);
+            }
+        } else {
+            WarnUnknownAttribute(context, GetJSONElement(reader, "anim"), key);
+            if (!SkipJSONMember(context, reader)) {
+                return false;
+            }
+        }
+    }
+    if (!reader.error.empty()) {
+        return SetError(context, reader.error);
+    }
+    return true;
+}
+
+bool ParseJSONSpriteData(ConversionContext &context, JSONReader &reader)
+{
+    //Read sprite and animation arrays of root object
+    std::string_view key;
+    for (bool first = true; ReadJSONKey(reader, key, first); first = false) {
+        if (key == "sprites" || key == "anims") {
+            bool is_sprites = (key == "sprites");
+            if (!ReadJSONContainer(context, reader, JSON_VALUE_ARRAY, is_sprites ? "sprites" : "anims")) {
+                return false;
+            }
+            for (bool first_item = true; NextJSONItem(reader, first_item); first_item = false) {
+                if (!ReadJSONContainer(context, reader, JSON_VALUE_OBJECT, is_sprites ? "sprite" : "anim")) {
+                    return false;
+                }
+                if (is_sprites ? !ParseJSONSprite(context, reader) : !ParseJSONAnim(context, reader)) {
+                    return false;
+                }
+            }
+            if (!reader.error.empty()) {
+                return SetError(context, reader.error);
+            }
+        } else {
+            WarnUnknownAttribute(context, GetJSONElement(reader, "spritedata"), key);
+            if (!SkipJSONMember(context, reader)) {
+                return false;
+            }
+        }
+    }
+    if (!reader.error.empty()) {
+        return SetError(context, reader.error);
+    }
+    return true;
+}
+
+bool BuildSpriteLookup(ConversionContext &context)
+{
+    SpriteProject &project = context.project;
+    context.sprite_lookup.clear();
+    context.sprite_lookup.reserve(project.sprite_list.size());
+    for (size_t i = 0; i < project.sprite_list.size(); i++) {
+        if (!context.sprite_lookup.emplace(project.sprite_list[i].name, i).second) {
+            //Fail if sprite name is already used
+            return SetError(context, "Duplicate sprite name " + project.sprite_list[i].name + ".");
+        }
+    }
+    return true;
+}
+
+bool FindSprite(ConversionContext &context, const std::string &name, uint16_t *idx)
+{
+    auto it = context.sprite_lookup.find(name);
+    if (it == context.sprite_lookup.end()) {
+        //Return false if not found
+        return false;
+    }
+    //Write index if found
+    *idx = it->second;
+    return true;
+}
+
+void CalcSpriteBoundingRects(SpriteProject &project)
+{
+    for (size_t i = 0; i < project.sprite_list.size(); i++) {
+        int16_t min_x, max_x, min_y, max_y;
+        //Set defaults for bounding rect in sprite
+        min_x = min_y = INT16_MAX;
+        max_x = max_y = INT16_MIN;
+        for (size_t j = 0; j < project.sprite_list[i].images.size(); j++) {
+            //Get image rectangle
+            int16_t x = project.sprite_list[i].images[j].x;
+            int16_t y = project.sprite_list[i].images[j].y;
+            int16_t w = project.sprite_list[i].images[j].w;
+            int16_t h = project.sprite_list[i].images[j].h;
+            //Update bounding rect based on image rectangle
+            if (x < min_x) {
+                min_x = x;
+            }
+            if (y < min_y) {
+                min_y = y;
+            }
+            if ((x + w) > max_x) {
+                max_x = x + w;
+            }
+            if ((y + h) > max_y) {
+                max_y = y + h;
+            }
+        }
+        //Set sprite bounding rectangle
+        project.sprite_list[i].min_x = min_x;
+        project.sprite_list[i].min_y = min_y;
+        project.sprite_list[i].max_x = max_x;
+        project.sprite_list[i].max_y = max_y;
+    }
+}
+
+void CreateSpriteHeader(SpriteProject &project, SpriteHeader &header)
+{
+    //Set sprite header info
+    header.sprite_ofs = 0x18;
+    header.sprite_count = project.sprite_list.size();
+    //Set animation header info
+    header.anim_ofs = header.sprite_ofs + (header.sprite_count * 12);
+    header.anim_count = project.anim_list.size();
+    //Set frame header info
+    header.frame_ofs = header.anim_ofs + (header.anim_count * 4);
+    //Calculate frame count
+    header.frame_count = 0;
+    for (size_t i = 0; i < project.anim_list.size(); i++) {
+        header.frame_count += project.anim_list[i].size();
+    }
+    //Set image header info
+    header.image_ofs = header.frame_ofs + (header.frame_count * 28);
+    //Calculate image count
+    header.image_count = 0;
+    for (size_t i = 0; i < project.sprite_list.size(); i++) {
+        header.image_count += project.sprite_list[i].images.size();
+    }
+}
+
+size_t GetSpriteFileSize(SpriteHeader &header)
+{
+    //Image section is last in file
+    return header.image_ofs + (header.image_count * 28);
+}
+
+void WriteSpriteHeader(uint8_t *dst, SpriteHeader &header)
+{
+    //Write count fields
+    WriteU16(&dst[0], header.sprite_count);
+    WriteU16(&dst[2], header.anim_count);
+    WriteU16(&dst[4], header.frame_count);
+    WriteU16(&dst[6], header.image_count);
+    //Write offset fields
+    WriteU32(&dst[8], header.sprite_ofs);
+    WriteU32(&dst[12], header.anim_ofs);
+    WriteU32(&dst[16], header.frame_ofs);
+    WriteU32(&dst[20], header.image_ofs);
+}
+
+void WriteSprites(SpriteProject &project, uint8_t *dst)
+{
+    uint16_t start_image = 0; //Start with image 0
+    //Loop over sprites
+    for (size_t i = 0; i < project.sprite_list.size(); i++) {
+        //Write image range
+        WriteU16(&dst[0], start_image);
+        WriteU16(&dst[2], project.sprite_list[i].images.size());
+        //Write bounding rectangle
+        WriteS16(&dst[4], project.sprite_list[i].min_x);
+        WriteS16(&dst[6], project.sprite_list[i].min_y);
+        WriteS16(&dst[8], project.sprite_list[i].max_x);
+        WriteS16(&dst[10], project.sprite_list[i].max_y);
+        //Get next starting image
+        start_image += project.sprite_list[i].images.size();
+        dst += 12;
+    }
+}
+
+void WriteAnims(SpriteProject &project, uint8_t *dst)
+{
+    uint16_t start_frame = 0; //Start with frame 0
+    //Loop over animations
+    for (size_t i = 0; i < project.anim_list.size(); i++) {
+        //Write animation frame range
+        WriteU16(&dst[0], start_frame);
+        WriteU16(&dst[2], project.anim_list[i].size());
+        //Get next starting frame
+        start_frame += project.anim_list[i].size();
+        dst += 4;
+    }
+}
+
+void WriteAnimFrame(uint8_t *dst, const AnimFrame &frame, int16_t anim_idx, int16_t next_frame)
+{
+    //Write sprite index
+    WriteU16(&dst[0], frame.sprite_idx);
+    //Write delay fields
+    WriteU8(&dst[2], frame.delay);
+    WriteU8(&dst[3], frame.max_delay);
+    //Write scale fields
+    WriteFloat(&dst[4], frame.x_scale);
+    WriteFloat(&dst[8], frame.y_scale);
+    //Write position fields
+    WriteFloat(&dst[12], frame.x);
+    WriteFloat(&dst[16], frame.y);
+    //Write angle
+    WriteS16(&dst[20], frame.angle);
+    WriteS16(&dst[22], anim_idx); //Animation index
+    WriteS16(&dst[24], next_frame); //Next frame
+    //Write dummy field needed for matching
+    WriteS16(&dst[26], 1);
+}
+
+void WriteAnimFrames(SpriteProject &project, uint8_t *dst)
+{
+    //Loop over animation frames
+    for (size_t i = 0; i < project.anim_list.size(); i++) {
+        for (size_t j = 0; j < project.anim_list[i].size(); j++) {
+            //Frames link to next frame of their animation, looping at end
+            WriteAnimFrame(dst, project.anim_list[i][j], i, (j + 1) % project.anim_list[i].size());
+            dst += 28;
+        }
+    }
+}
+
+void WriteImage(uint8_t *dst, const Image &image)
+{
+    //Write texture ID
+    WriteU16(&dst[0], image.texture_id);
+    //Write number of palettes
+    WriteU16(&dst[2], image.num_palettes);
+    //Write image position
+    WriteS16(&dst[4], image.x);
+    WriteS16(&dst[6], image.y);
+    //Write source position
+    WriteU16(&dst[8], image.src_x);
+    WriteU16(&dst[10], image.src_y);
+    //Write image size
+    WriteU16(&dst[12], image.w);
+    WriteU16(&dst[14], image.h);
+    WriteU8(&dst[16], 0); //Unknown field 1
+    //Write alpha mode
+    WriteU8(&dst[17], image.alpha_mode);
+    WriteU8(&dst[18], 0); //Unknown field 2
+    WriteU8(&dst[19], 0); //Unknown field 3
+    //Write angle
+    WriteS16(&dst[20], image.angle);
+    //Write blend mode
+    WriteU8(&dst[22], image.blend_mode);
+    //Write bilinear flag
+    WriteBool(&dst[23], image.bilinear);
+    //Write flip flags
+    WriteU8(&dst[24], image.flip);
+    WriteU8(&dst[25], 255); //Alpha field (always 255)
+    WriteU16(&dst[26], 0); //Unknown field 4
+}
+
+void WriteImages(SpriteProject &project, uint8_t *dst)
+{
+    //Loop over images
+    for (size_t i = 0; i < project.sprite_list.size(); i++) {
+        for (size_t j = 0; j < project.sprite_list[i].images.size(); j++) {
+            WriteImage(dst, project.sprite_list[i].images[j]);
+            dst += 28;
+        }
+    }
+}
+
+bool CheckSpriteCounts(ConversionContext &context)
+{
+    //Sprite header counts are 16-bit and records past them would not fit in file
+    const SpriteProject &project = context.project;
+    size_t frame_count = 0;
+    size_t image_count = 0;
+    for (size_t i = 0; i < project.anim_list.size(); i++) {
+        frame_count += project.anim_list[i].size();
+    }
+    for (size_t i = 0; i < project.sprite_list.size(); i++) {
+        image_count += project.sprite_list[i].images.size();
+    }
+    if (project.sprite_list.size() > UINT16_MAX || project.anim_list.size() > UINT16_MAX || frame_count > UINT16_MAX || image_count > UINT16_MAX) {
+        return SetError(context, "Too many records for sprite file. Sprite, animation, frame, and image counts must be at most " + std::to_string(UINT16_MAX) + ".");
+    }
+    return true;
+}
+
+bool EncodeSprite(ConversionContext &context, std::vector<uint8_t> &buffer)
+{
+    if (!CheckSpriteCounts(context)) {
+        return false;
+    }
+    SpriteProject &project = context.project;
+    {
+        PhaseScope scope(context, PHASE_BOUNDS);
+        CalcSpriteBoundingRects(project); //Get bounding rectangles for sprites
+    }
+    PhaseScope scope(context, PHASE_ENCODE);
+    //Create sprite header to write
+    SpriteHeader header;
+    CreateSpriteHeader(project, header);
+    //Allocate whole file at once
+    buffer.assign(GetSpriteFileSize(header), 0);
+    WriteSpriteHeader(&buffer[0], header);
+    //Write file sections
+    WriteSprites(project, &buffer[header.sprite_ofs]);
+    WriteAnims(project, &buffer[header.anim_ofs]);
+    WriteAnimFrames(project, &buffer[header.frame_ofs]);
+    WriteImages(project, &buffer[header.image_ofs]);
+    return true;
+}
+
+//Record sizes of sprite project files
+const size_t PROJECT_HEADER_SIZE = 32;
+const size_t PROJECT_SPRITE_SIZE = 24;
+const size_t PROJECT_ANIM_SIZE = 8;
+const size_t PROJECT_FRAME_SIZE = 24;
+const size_t PROJECT_IMAGE_SIZE = 24;
+
+struct ProjectHeader {
+    uint16_t version;
+    uint32_t sprite_count;
+    uint32_t anim_count;
+    uint32_t frame_count;
+    uint32_t image_count;
+    uint32_t name_size; //Bytes of sprite names stored after images
+};
+
+uint64_t GetProjectFileSize(ProjectHeader &header)
+{
+    //Sections are stored in order after header
+    return PROJECT_HEADER_SIZE + ((uint64_t)header.sprite_count * PROJECT_SPRITE_SIZE) + ((uint64_t)header.anim_count * PROJECT_ANIM_SIZE)
+        + ((uint64_t)header.frame_count * PROJECT_FRAME_SIZE) + ((uint64_t)header.image_count * PROJECT_IMAGE_SIZE) + header.name_size;
+}
+
+void WriteProjectFrame(uint8_t *dst, const AnimFrame &frame)
+{
+    WriteU16(&dst[0], frame.sprite_idx);
+    WriteU8(&dst[2], frame.delay);
+    WriteU8(&dst[3], frame.max_delay);
+    WriteFloat(&dst[4], frame.x_scale);
+    WriteFloat(&dst[8], frame.y_scale);
+    WriteFloat(&dst[12], frame.x);
+    WriteFloat(&dst[16], frame.y);
+    WriteS16(&dst[20], frame.angle);
+    WriteU16(&dst[22], 0); //Padding
+}
+
+void WriteProjectImage(uint8_t *dst, const Image &image)
+{
+    WriteU16(&dst[0], image.texture_id);
+    WriteU16(&dst[2], image.num_palettes);
+    WriteS16(&dst[4], image.x);
+    WriteS16(&dst[6], image.y);
+    WriteU16(&dst[8], image.src_x);
+    WriteU16(&dst[10], image.src_y);
+    WriteU16(&dst[12], image.w);
+    WriteU16(&dst[14], image.h);
+    WriteS16(&dst[16], image.angle);
+    WriteU8(&dst[18], image.alpha_mode);
+    WriteU8(&dst[19], image.blend_mode);
+    WriteBool(&dst[20], image.bilinear);
+    WriteU8(&dst[21], image.flip);
+    WriteU16(&dst[22], 0); //Padding
+}
+
+void EncodeSpriteProject(const SpriteProject &project, std::vector<uint8_t> &buffer)
+{
+    //Count records of each section
+    ProjectHeader header;
+    header.version = SPRITE_PROJECT_VERSION;
+    header.sprite_count = project.sprite_list.size();
+    header.anim_count = project.anim_list.size();
+    header.frame_count = 0;
+    header.image_count = 0;
+    header.name_size = 0;
+    for (size_t i = 0; i < project.anim_list.size(); i++) {
+        header.frame_count += project.anim_list[i].size();
+    }
+    for (size_t i = 0; i < project.sprite_list.size(); i++) {
+        header.image_count += project.sprite_list[i].images.size();
+        header.name_size += project.sprite_list[i].name.size();
+    }
+    //Allocate whole file at once
+    buffer.assign(GetProjectFileSize(header), 0);
+    uint8_t *dst = &buffer[0];
+    memcpy(&dst[0], SPRITE_PROJECT_MAGIC, 4);
+    WriteU16(&dst[4], header.version);
+    WriteU16(&dst[6], 0); //Reserved
+    WriteU32(&dst[8], header.sprite_count);
+    WriteU32(&dst[12], header.anim_count);
+    WriteU32(&dst[16], header.frame_count);
+    WriteU32(&dst[20], header.image_count);
+    WriteU32(&dst[24], header.name_size);
+    WriteU32(&dst[28], 0); //Reserved
+    uint8_t *sprite_data = dst + PROJECT_HEADER_SIZE;
+    uint8_t *anim_data = sprite_data + (header.sprite_count * PROJECT_SPRITE_SIZE);
+    uint8_t *frame_data = anim_data + (header.anim_count * PROJECT_ANIM_SIZE);
+    uint8_t *image_data = frame_data + (header.frame_count * PROJECT_FRAME_SIZE);
+    uint8_t *name_data = image_data + (header.image_count * PROJECT_IMAGE_SIZE);
+    //Write sprites with their images and names
+    uint32_t start_image = 0;
+    uint32_t name_ofs = 0;
+    for (size_t i = 0; i < project.sprite_list.size(); i++) {
+        const Sprite &sprite = project.sprite_list[i];
+        uint8_t *src = &sprite_data[i * PROJECT_SPRITE_SIZE];
+        WriteU32(&src[0], name_ofs);
+        WriteU32(&src[4], sprite.name.size());
+        WriteU32(&src[8], start_image);
+        WriteU32(&src[12], sprite.images.size());
+        WriteS16(&src[16], sprite.min_x);
+        WriteS16(&src[18], sprite.min_y);
+        WriteS16(&src[20], sprite.max_x);
+        WriteS16(&src[22], sprite.max_y);
+        memcpy(&name_data[name_ofs], sprite.name.data(), sprite.name.size());
+        for (size_t j = 0; j < sprite.images.size(); j++) {
+            WriteProjectImage(&image_data[(start_image + j) * PROJECT_IMAGE_SIZE], sprite.images[j]);
+        }
+        name_ofs += sprite.name.size();
+        start_image += sprite.images.size();
+    }
+    //Write animations with their frames
+    uint32_t start_frame = 0;
+    for (size_t i = 0; i < project.anim_list.size(); i++) {
+        WriteU32(&anim_data[(i * PROJECT_ANIM_SIZE) + 0], start_frame);
+        WriteU32(&anim_data[(i * PROJECT_ANIM_SIZE) + 4], project.anim_list[i].size());
+        for (size_t j = 0; j < project.anim_list[i].size(); j++) {
+            WriteProjectFrame(&frame_data[(start_frame + j) * PROJECT_FRAME_SIZE], project.anim_list[i][j]);
+        }
+        start_frame += project.anim_list[i].size();
+    }
+}
+
+void ReadProjectFrame(const uint8_t *src, AnimFrame &frame)
+{
+    frame.sprite_idx = ReadU16(&src[0]);
+    frame.delay = ReadU8(&src[2]);
+    frame.max_delay = ReadU8(&src[3]);
+    frame.x_scale = ReadFloat(&src[4]);
+    frame.y_scale = ReadFloat(&src[8]);
+    frame.x = ReadFloat(&src[12]);
+    frame.y = ReadFloat(&src[16]);
+    frame.angle = ReadS16(&src[20]);
+}
+
+void ReadProjectImage(const uint8_t *src, Image &image)
+{
+    image.texture_id = ReadU16(&src[0]);
+    image.num_palettes = ReadU16(&src[2]);
+    image.x = ReadS16(&src[4]);
+    image.y = ReadS16(&src[6]);
+    image.src_x = ReadU16(&src[8]);
+    image.src_y = ReadU16(&src[10]);
+    image.w = ReadU16(&src[12]);
+    image.h = ReadU16(&src[14]);
+    image.angle = ReadS16(&src[16]);
+    image.alpha_mode = ReadU8(&src[18]);
+    image.blend_mode = ReadU8(&src[19]);
+    image.bilinear = ReadBool(&src[20]);
+    image.flip = ReadU8(&src[21]);
+}
+
+std::string GetTempName(std::string path)
+{
+    //Name is unique between threads and processes writing same path
+    static std::atomic<uint32_t> temp_counter(0);
+#ifdef _WIN32
+    uint32_t process_id = GetCurrentProcessId();
+#else
+    uint32_t process_id = getpid();
+#endif
+    return path + "." + std::to_string(process_id) + "." + std::to_string(temp_counter++) + ".tmp";
+}
+
+bool ReplaceOutputFile(std::string temp_path, std::string path)
+{
+    //Replace output file with temporary file
+#ifdef _WIN32
+    bool success = MoveFileExA(temp_path.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING);
+#else
+    bool success = rename(temp_path.c_str(), path.c_str()) == 0;
+#endif
+    if (!success) {
+        remove(temp_path.c_str());
+    }
+    return success;
+}
+
+bool WriteOutputParts(std::string path, const std::vector<std::string_view> &parts)
+{
+    //Write to temporary file so output is never left half-written
+    std::string temp_path = GetTempName(path);
+    FILE *file = fopen(temp_path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    setvbuf(file, nullptr, _IONBF, 0); //Write each part in one call
+    bool success = true;
+    for (size_t i = 0; i < parts.size() && success; i++) {
+        success = fwrite(parts[i].data(), 1, parts[i].size(), file) == parts[i].size();
+    }
+    success = (fclose(file) == 0) && success;
+    if (!success) {
+        remove(temp_path.c_str());
+        return false;
+    }
+    return ReplaceOutputFile(temp_path, path);
+}
+
+bool WriteOutputFile(std::string path, const void *data, size_t size)
+{
+    std::vector<std::string_view> parts;
+    parts.emplace_back((const char *)data, size);
+    return WriteOutputParts(path, parts);
+}
+
+uint64_t RotateLeft64(uint64_t value, int amount)
+{
+    return (value << amount) | (value >> (64 - amount));
+}
+
+uint64_t ReadU64(const uint8_t *src)
+{
+    //Return bytes in little-endian order
+    return ((uint64_t)ReadU32(&src[4]) << 32) | ReadU32(src);
+}
+
+uint64_t HashRound(uint64_t acc, uint64_t input)
+{
+    acc += input * 0xC2B2AE3D27D4EB4FULL;
+    acc = RotateLeft64(acc, 31);
+    return acc * 0x9E3779B185EBCA87ULL;
+}
+
+uint64_t HashMerge(uint64_t acc, uint64_t value)
+{
+    acc ^= HashRound(0, value);
+    return (acc * 0x9E3779B185EBCA87ULL) + 0x85EBCA77C2B2AE63ULL;
+}
+
+uint64_t HashData(const uint8_t *data, size_t size, uint64_t seed)
+{
+    //XXH64 hash
+    const uint64_t prime1 = 0x9E3779B185EBCA87ULL;
+    const uint64_t prime2 = 0xC2B2AE3D27D4EB4FULL;
+    const uint64_t prime3 = 0x165667B19E3779F9ULL;
+    const uint64_t prime4 = 0x85EBCA77C2B2AE63ULL;
+    const uint64_t prime5 = 0x27D4EB2F165667C5ULL;
+    const uint8_t *end = data + size;
+    uint64_t hash;
+    if (size >= 32) {
+        //Hash 32-byte stripes in 4 lanes
+        uint64_t v1 = seed + prime1 + prime2;
+        uint64_t v2 = seed + prime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - prime1;
+        while (end - data >= 32) {
+            v1 = HashRound(v1, ReadU64(&data[0]));
+            v2 = HashRound(v2, ReadU64(&data[8]));
+            v3 = HashRound(v3, ReadU64(&data[16]));
+            v4 = HashRound(v4, ReadU64(&data[24]));
+            data += 32;
+        }
+        hash = RotateLeft64(v1, 1) + RotateLeft64(v2, 7) + RotateLeft64(v3, 12) + RotateLeft64(v4, 18);
+        hash = HashMerge(hash, v1);
+        hash = HashMerge(hash, v2);
+        hash = HashMerge(hash, v3);
+        hash = HashMerge(hash, v4);
+    } else {
+        hash = seed + prime5;
+    }
+    hash += size;
+    //Hash remaining bytes
+    while (end - data >= 8) {
+        hash ^= HashRound(0, ReadU64(data));
+        hash = (RotateLeft64(hash, 27) * prime1) + prime4;
+        data += 8;
+    }
+    if (end - data >= 4) {
+        hash ^= ReadU32(data) * prime1;
+        hash = (RotateLeft64(hash, 23) * prime2) + prime3;
+        data += 4;
+    }
+    while (data < end) {
+        hash ^= *data * prime5;
+        hash = RotateLeft64(hash, 11) * prime1;
+        data++;
+    }
+    //Mix final bits
+    hash ^= hash >> 33;
+    hash *= prime2;
+    hash ^= hash >> 29;
+    hash *= prime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+std::string GetCachePath(std::string cache_dir, const uint8_t *data, size_t size)
+{
+    //Key includes library version so format changes do not reuse old outputs
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.spr", (unsigned long long)HashData(data, size, SPRITELIB_VERSION));
+    return (std::filesystem::u8path(cache_dir) / name).u8string();
+}
+
+bool CopyCachedFile(std::string cache_path, std::string path)
+{
+    std::error_code ec;
+    if (!std::filesystem::is_regular_file(std::filesystem::u8path(cache_path), ec)) {
+        return false;
+    }
+    //Prefer hard link over copying file contents
+    std::string temp_path = GetTempName(path);
+    std::filesystem::create_hard_link(std::filesystem::u8path(cache_path), std::filesystem::u8path(temp_path), ec);
+    if (ec) {
+        std::filesystem::copy_file(std::filesystem::u8path(cache_path), std::filesystem::u8path(temp_path), ec);
+        if (ec) {
+            remove(temp_path.c_str());
+            return false;
+        }
+    }
+    return ReplaceOutputFile(temp_path, path);
+}
+
+std::string GetCacheWarningsPath(std::string cache_path)
+{
+    //Warnings of a cached build sit next to its output
+    return std::filesystem::u8path(cache_path).replace_extension(".warnings").u8string();
+}
+
+bool WriteCachedWarnings(std::string path, const std::vector<std::string> &warnings)
+{
+    //One warning per line with backslashes and line breaks escaped
+    std::string text;
+    for (size_t i = 0; i < warnings.size(); i++) {
+        for (char c : warnings[i]) {
+            if (c == '\\') {
+                text += "\\\\";
+            } else if (c == '\n') {
+                text += "\\n";
+            } else {
+                text += c;
+            }
+        }
+        text += '\n';
+    }
+    return WriteOutputFile(path, text.data(), text.size());
+}
+
+void ReadCachedWarnings(std::string path, std::vector<std::string> &warnings)
+{
+    //Builds without warnings leave no warnings file
+    InputFile file;
+    if (!OpenInputFile(path, file)) {
+        return;
+    }
+    std::string warning;
+    for (size_t i = 0; i < file.size; i++) {
+        char c = file.data[i];
+        if (c == '\n') {
+            warnings.push_back(warning);
+            warning.clear();
+        } else if (c == '\\' && i + 1 < file.size) {
+            warning += (file.data[++i] == 'n') ? '\n' : (char)file.data[i];
+        } else {
+            warning += c;
+        }
+    }
+    CloseInputFile(file);
+}
+
+bool ResolveFrameSpriteNames(ConversionContext &context)
+{
+    SpriteProject &project = context.project;
+    size_t name_idx = 0;
+    //Loop over all animation frames
+    for (size_t i = 0; i < project.anim_list.size(); i++) {
+        for (size_t j = 0; j < project.anim_list[i].size(); j++) {
+            const std::string &name = context.frame_sprite_names[name_idx++];
+            if (!FindSprite(context, name, &project.anim_list[i][j].sprite_idx)) {
+                //Fail if sprite name is not found
+                return SetError(context, "Sprite name " + name + " not found.");
+            }
+        }
+    }
+    //Names are no longer needed
+    std::vector<std::string>().swap(context.frame_sprite_names);
+    return true;
+}
+
+bool OpenConversionInput(ConversionContext &context, std::string in_file, InputFile &file)
+{
+    //Mapped files are only paged in as they are read by later phases
+    context.stats.files++;
+    PhaseScope scope(context, PHASE_READ_FILE);
+    if (!OpenInputFile(in_file, file)) {
+        //Fail if could not open
+        return SetError(context, "Failed to open " + in_file + " for reading.");
+    }
+    context.stats.bytes_in += file.size;
+    return true;
+}
+
+bool WriteConversionOutput(ConversionContext &context, std::string out_file, const std::vector<std::string_view> &parts)
+{
+    PhaseScope scope(context, PHASE_WRITE_FILE);
+    if (!WriteOutputParts(out_file, parts)) {
+        return SetError(context, "Failed to open " + out_file + " for writing.");
+    }
+    for (size_t i = 0; i < parts.size(); i++) {
+        context.stats.bytes_out += parts[i].size();
+    }
+    return true;
+}
+
+bool DecodeSprite(ConversionContext &context, const uint8_t *data, size_t size)
+{
+    //Read and verify sprite header
+    SpriteHeader header;
+    {
+        PhaseScope scope(context, PHASE_VERIFY);
+        if (size < 0x18) {
+            //Fail if header does not fit in file
+            return SetError(context, "Invalid sprite file.");
+        }
+        ReadSpriteHeader(data, header);
+        if (!VerifySpriteHeader(header, size)) {
+            //Fail if verification fails
+            return SetError(context, "Invalid sprite file.");
+        }
+    }
+    CountSpriteRecords(context.stats, header);
+    //Read animation and sprite data
+    bool success;
+    {
+        PhaseScope scope(context, PHASE_READ_ANIMS);
+        success = ReadAnims(context.project, data, size, header);
+    }
+    if (success) {
+        PhaseScope scope(context, PHASE_READ_SPRITES);
+        success = ReadSprites(context.project, data, size, header);
+    }
+    if (!success) {
+        //Fail if animation or sprite references data outside of file
+        return SetError(context, "Invalid sprite file.");
+    }
+    return true;
+}
+
+bool IsSpriteProject(const uint8_t *data, size_t size)
+{
+    return size >= 4 && memcmp(data, SPRITE_PROJECT_MAGIC, 4) == 0;
+}
+
+bool DecodeSpriteProject(ConversionContext &context, const uint8_t *data, size_t size)
+{
+    //Read and verify project header
+    ProjectHeader header;
+    {
+        PhaseScope scope(context, PHASE_VERIFY);
+        if (size < PROJECT_HEADER_SIZE || !IsSpriteProject(data, size)) {
+            return SetError(context, "Invalid sprite project file.");
+        }
+        header.version = ReadU16(&data[4]);
+        header.sprite_count = ReadU32(&data[8]);
+        header.anim_count = ReadU32(&data[12]);
+        header.frame_count = ReadU32(&data[16]);
+        header.image_count = ReadU32(&data[20]);
+        header.name_size = ReadU32(&data[24]);
+        if (header.version != SPRITE_PROJECT_VERSION) {
+            return SetError(context, "Unsupported sprite project version " + std::to_string(header.version) + ".");
+        }
+        if (GetProjectFileSize(header) != size) {
+            return SetError(context, "Invalid sprite project file.");
+        }
+    }
+    const uint8_t *sprite_data = data + PROJECT_HEADER_SIZE;
+    const uint8_t *anim_data = sprite_data + (header.sprite_count * PROJECT_SPRITE_SIZE);
+    const uint8_t *frame_data = anim_data + (header.anim_count * PROJECT_ANIM_SIZE);
+    const uint8_t *image_data = frame_data + (header.frame_count * PROJECT_FRAME_SIZE);
+    const char *name_data = (const char *)(image_data + (header.image_count * PROJECT_IMAGE_SIZE));
+    //Read sprites with their images and names
+    SpriteProject &project = context.project;
+    {
+        PhaseScope scope(context, PHASE_READ_SPRITES);
+        project.sprite_list.resize(header.sprite_count);
+        for (uint32_t i = 0; i < header.sprite_count; i++) {
+            Sprite &sprite = project.sprite_list[i];
+            const uint8_t *src = &sprite_data[i * PROJECT_SPRITE_SIZE];
+            uint32_t name_ofs = ReadU32(&src[0]);
+            uint32_t name_len = ReadU32(&src[4]);
+            uint32_t start_image = ReadU32(&src[8]);
+            uint32_t num_images = ReadU32(&src[12]);
+            //Check if name or image range exceeds its section
+            if ((uint64_t)name_ofs + name_len > header.name_size || (uint64_t)start_image + num_images > header.image_count) {
+                return SetError(context, "Invalid sprite project file.");
+            }
+            sprite.name.assign(&name_data[name_ofs], name_len);
+            sprite.min_x = ReadS16(&src[16]);
+            sprite.min_y = ReadS16(&src[18]);
+            sprite.max_x = ReadS16(&src[20]);
+            sprite.max_y = ReadS16(&src[22]);
+            sprite.images.resize(num_images);
+            for (uint32_t j = 0; j < num_images; j++) {
+                ReadProjectImage(&image_data[(start_image + j) * PROJECT_IMAGE_SIZE], sprite.images[j]);
+            }
+        }
+    }
+    //Read animations with their frames
+    {
+        PhaseScope scope(context, PHASE_READ_ANIMS);
+        project.anim_list.resize(header.anim_count);
+        for (uint32_t i = 0; i < header.anim_count; i++) {
+            uint32_t start_frame = ReadU32(&anim_data[(i * PROJECT_ANIM_SIZE) + 0]);
+            uint32_t num_frames = ReadU32(&anim_data[(i * PROJECT_ANIM_SIZE) + 4]);
+            //Check if frame range exceeds its section
+            if ((uint64_t)start_frame + num_frames > header.frame_count) {
+                return SetError(context, "Invalid sprite project file.");
+            }
+            project.anim_list[i].resize(num_frames);
+            for (uint32_t j = 0; j < num_frames; j++) {
+                ReadProjectFrame(&frame_data[(start_frame + j) * PROJECT_FRAME_SIZE], project.anim_list[i][j]);
+                //Frames must refer to sprites in file like resolved XML and JSON frames do
+                if (project.anim_list[i][j].sprite_idx >= header.sprite_count) {
+                    return SetError(context, "Invalid sprite project file.");
+                }
+            }
+        }
+    }
+    CountSpriteRecords(context.stats, project);
+    PhaseScope scope(context, PHASE_RESOLVE);
+    return BuildSpriteLookup(context);
+}
+
+bool ParseSpriteXML(ConversionContext &context, const char *xml, size_t size)
+{
+    {
+        PhaseScope scope(context, PHASE_PARSE);
+        //Read XML elements as they appear in text
+        XMLReader reader;
+        InitXMLReader(reader, xml, size);
+        bool found_root = false;
+        while (true) {
+            XMLEventType event = ReadXMLEvent(reader);
+            if (event == XML_EVENT_DOCUMENT_END) {
+                break;
+            }
+            if (event != XML_EVENT_START) {
+                return SetError(context, reader.error);
+            }
+            if (reader.name == "spritedata" && !found_root) {
+                //Parse sprite data from first root element
+                found_root = true;
+                if (!ParseSpriteDataParallel(context, reader, xml, size)) {
+                    return false;
+                }
+            } else if (!SkipXMLElement(reader)) {
+                return SetError(context, reader.error);
+            }
+        }
+        if (!found_root) {
+            //Fail if root element is not found
+            return SetError(context, "No root element found.");
+        }
+    }
+    CountSpriteRecords(context.stats, context.project);
+    PhaseScope scope(context, PHASE_RESOLVE);
+    if (!BuildSpriteLookup(context)) {
+        return false;
+    }
+    //Convert frame sprite names to indices
+    return ResolveFrameSpriteNames(context);
+}
+
+bool ParseSpriteJSON(ConversionContext &context, const char *json, size_t size)
+{
+    {
+        PhaseScope scope(context, PHASE_PARSE);
+        //Read JSON values as they appear in text
+        JSONReader reader;
+        InitJSONReader(reader, json, size);
+        if (!ReadJSONContainer(context, reader, JSON_VALUE_OBJECT, "root")) {
+            return false;
+        }
+        if (!ParseJSONSpriteData(context, reader)) {
+            return false;
+        }
+        if (!FinishJSONReader(reader)) {
+            return SetError(context, reader.error);
+        }
+    }
+    CountSpriteRecords(context.stats, context.project);
+    PhaseScope scope(context, PHASE_RESOLVE);
+    if (!BuildSpriteLookup(context)) {
+        return false;
+    }
+    //Convert frame sprite names to indices
+    return ResolveFrameSpriteNames(context);
+}
+
+bool DumpSpriteData(ConversionContext &context, const uint8_t *data, size_t size, SpriteFormat format, const std::function<bool(const std::vector<std::string_view> &)> &write_output)
+{
+    //Print text formats straight from sprite file data
+    std::deque<tinyxml2::XMLPrinter> printers;
+    std::vector<std::string> ranges;
+    std::vector<std::string_view> parts;
+    std::vector<uint8_t> buffer;
+    bool success;
+    if (format == SPRITE_FORMAT_XML) {
+        success = PrintSpriteFileXML(context, data, size, printers, parts);
+    } else if (format == SPRITE_FORMAT_JSON) {
+        success = PrintSpriteFileJSON(context, data, size, ranges, parts);
+    } else {
+        //Sprite projects are encoded from the decoded sprite file
+        success = DecodeSprite(context, data, size);
+        if (success) {
+            PhaseScope scope(context, PHASE_ENCODE);
+            EncodeSpriteProject(context.project, buffer);
+            parts.emplace_back((const char *)buffer.data(), buffer.size());
+        }
+    }
+    if (!success) {
+        return false;
+    }
+    return write_output(parts);
+}
+
+bool DumpSprite(ConversionContext &context, std::string in_file, std::string out_file, SpriteFormat format)
+{
+    TraceScope file_scope(context.trace, in_file, "file");
+    InputFile file;
+    if (!OpenConversionInput(context, in_file, file)) {
+        return false;
+    }
+    bool file_open = true;
+    bool success = DumpSpriteData(context, file.data, file.size, format, [&](const std::vector<std::string_view> &parts) {
+        //Output does not refer to input so release it before writing
+        CloseInputFile(file);
+        file_open = false;
+        return WriteConversionOutput(context, out_file, parts);
+    });
+    if (file_open) {
+        CloseInputFile(file);
+    }
+    return success;
+}
+
+SpriteFormat GetSourceFormat(const uint8_t *data, size_t size)
+{
+    //Sprite projects are told apart from text by their magic number
+    if (IsSpriteProject(data, size)) {
+        return SPRITE_FORMAT_PROJECT;
+    }
+    //JSON starts with an object or array where XML starts with markup
+    size_t pos = 0;
+    if (size >= 3 && memcmp(data, "\xEF\xBB\xBF", 3) == 0) {
+        pos = 3;
+    }
+    while (pos < size && IsXMLSpace(data[pos])) {
+        pos++;
+    }
+    if (pos < size && (data[pos] == '{' || data[pos] == '[')) {
+        return SPRITE_FORMAT_JSON;
+    }
+    return SPRITE_FORMAT_XML;
+}
+
+bool LoadSpriteSource(ConversionContext &context, const uint8_t *data, size_t size)
+{
+    switch (GetSourceFormat(data, size)) {
+        case SPRITE_FORMAT_PROJECT:
+            return DecodeSpriteProject(context, data, size);
+        case SPRITE_FORMAT_JSON:
+            return ParseSpriteJSON(context, (const char *)data, size);
+        default:
+            return ParseSpriteXML(context, (const char *)data, size);
+    }
+}
+
+bool ConvertProject(ConversionContext &context, std::string in_file, std::string out_file, SpriteFormat format)
+{
+    TraceScope file_scope(context.trace, in_file, "file");
+    InputFile file;
+    if (!OpenConversionInput(context, in_file, file)) {
+        return false;
+    }
+    bool success = LoadSpriteSource(context, file.data, file.size);
+    CloseInputFile(file);
+    if (!success) {
+        return false;
+    }
+    //Write in requested format
+    std::string text;
+    std::vector<uint8_t> buffer;
+    std::vector<std::string_view> parts;
+    if (format == SPRITE_FORMAT_XML) {
+        if (!PrintSpriteXML(context, text)) {
+            return false;
+        }
+        parts.push_back(text);
+    } else if (format == SPRITE_FORMAT_JSON) {
+        if (!PrintSpriteJSON(context, text)) {
+            return false;
+        }
+        parts.push_back(text);
+    } else {
+        PhaseScope scope(context, PHASE_ENCODE);
+        EncodeSpriteProject(context.project, buffer);
+        parts.emplace_back((const char *)buffer.data(), buffer.size());
+    }
+    return WriteConversionOutput(context, out_file, parts);
+}
+
+bool BuildSprite(ConversionContext &context, std::string in_file, std::string out_file)
+{
+    TraceScope file_scope(context.trace, in_file, "file");
+    //Try to open XML, JSON, or sprite project file
+    InputFile file;
+    if (!OpenConversionInput(context, in_file, file)) {
+        return false;
+    }
+    std::string cache_path;
+    if (!context.cache_dir.empty()) {
+        //Reuse output built from identical input
+        PhaseScope scope(context, PHASE_CACHE);
+        cache_path = GetCachePath(context.cache_dir, file.data, file.size);
+        if (CopyCachedFile(cache_path, out_file)) {
+            CloseInputFile(file);
+            //Give same diagnostics as the build that filled the cache
+            ReadCachedWarnings(GetCacheWarningsPath(cache_path), context.warnings);
+            context.cache_hit = true;
+            return true;
+        }
+    }
+    //Parse sprite data
+    bool success = LoadSpriteSource(context, file.data, file.size);
+    CloseInputFile(file);
+    if (!success) {
+        return false;
+    }
+    //Build sprite file in memory
+    std::vector<uint8_t> buffer;
+    if (!EncodeSprite(context, buffer)) {
+        return false;
+    }
+    //Try to write output file
+    std::vector<std::string_view> parts(1, std::string_view((const char *)buffer.data(), buffer.size()));
+    if (!WriteConversionOutput(context, out_file, parts)) {
+        return false;
+    }
+    if (!cache_path.empty()) {
+        //Failing to fill cache only costs a rebuild later
+        PhaseScope scope(context, PHASE_CACHE);
+        std::error_code ec;
+        std::filesystem::create_directories(std::filesystem::u8path(context.cache_dir), ec);
+        //Warnings go first so a cached output is never found without them
+        if (context.warnings.empty() || WriteCachedWarnings(GetCacheWarningsPath(cache_path), context.warnings)) {
+            WriteOutputFile(cache_path, buffer.data(), buffer.size());
+        }
+    }
+    return true;
+}
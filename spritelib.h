@@ -0,0 +1,130 @@
+#ifndef SPRITELIB_H
+#define SPRITELIB_H
+
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include "stats.h"
+#include "trace.h"
+
+//Increase whenever output of any conversion changes to invalidate build caches
+#define SPRITELIB_VERSION 2
+
+//Sprite project files start with this magic number followed by a version
+#define SPRITE_PROJECT_MAGIC "SPRJ"
+#define SPRITE_PROJECT_VERSION 1
+
+struct AnimFrame {
+    uint16_t sprite_idx; //Index into sprite_list
+    uint8_t delay;
+    uint8_t max_delay; //Must be greater than delay to apply delay randomization
+    float x_scale;
+    float y_scale;
+    float x;
+    float y;
+    int16_t angle; //0-4095 equivalent to a circle
+};
+
+struct Image {
+    uint16_t texture_id;
+    uint16_t num_palettes; //Treated as consecutive texture_ids starting from texture_id
+    int16_t x;
+    int16_t y;
+    uint16_t src_x;
+    uint16_t src_y;
+    uint16_t w;
+    uint16_t h;
+    uint8_t alpha_mode; //0=100% alpha, 1=75% alpha, 2=50% alpha, 3=25% alpha
+    int16_t angle; //0-4095 equivalent to a circle
+    uint8_t blend_mode; //0=normal, 1=additive, 2=mask, 3=none
+    bool bilinear;
+    uint8_t flip; //0x1=x-flip, 0x2=y-flip
+};
+
+struct Sprite {
+    std::string name;
+    int16_t min_x;
+    int16_t min_y;
+    int16_t max_x;
+    int16_t max_y;
+    std::vector<Image> images;
+};
+
+//Formats sprite data can be converted between besides sprite files
+enum SpriteFormat {
+    SPRITE_FORMAT_XML,
+    SPRITE_FORMAT_JSON,
+    SPRITE_FORMAT_PROJECT
+};
+
+struct SpriteHeader {
+    uint16_t sprite_count;
+    uint16_t anim_count;
+    uint16_t frame_count;
+    uint16_t image_count;
+    uint32_t sprite_ofs;
+    uint32_t anim_ofs;
+    uint32_t frame_ofs;
+    uint32_t image_ofs;
+};
+
+struct SpriteProject {
+    std::vector<std::vector<AnimFrame>> anim_list;
+    std::vector<Sprite> sprite_list;
+};
+
+struct ConversionContext {
+    SpriteProject project;
+    std::unordered_map<std::string, uint16_t> sprite_lookup; //Maps sprite names to indices in sprite_list
+    std::vector<std::string> frame_sprite_names; //Sprite names of parsed frames awaiting resolution
+    std::string error; //Reason the last conversion failed
+    std::vector<std::string> warnings; //Problems which did not stop the conversion
+    std::unordered_set<std::string> warned_attributes; //Unknown attributes already warned about
+    std::string cache_dir; //Directory of cached build outputs, empty to disable cache
+    bool cache_hit = false; //Last build was copied from cache
+    unsigned num_threads = 1; //Threads used to parse a large XML file
+    ConversionStats stats = {}; //Time spent in each phase and amount of data converted
+    TraceRecorder *trace = nullptr; //Receives begin and end events of files and phases if set
+    bool perf_counters = false; //Measure phases with hardware counters where permitted
+    bool mem_report = false; //Count heap allocations of phases, needs EnableAllocationTracking
+};
+
+//Decodes sprite file data into context.project
+bool DecodeSprite(ConversionContext &context, const uint8_t *data, size_t size);
+//Encodes context.project into sprite file data, fails if counts do not fit in sprite header
+bool EncodeSprite(ConversionContext &context, std::vector<uint8_t> &buffer);
+//Parses sprite XML text into context.project
+bool ParseSpriteXML(ConversionContext &context, const char *xml, size_t size);
+//Prints context.project as sprite XML text
+bool PrintSpriteXML(ConversionContext &context, std::string &xml);
+//Parses sprite JSON text into context.project
+bool ParseSpriteJSON(ConversionContext &context, const char *json, size_t size);
+//Prints context.project as sprite JSON text
+bool PrintSpriteJSON(ConversionContext &context, std::string &json);
+//Checks for sprite project magic number
+bool IsSpriteProject(const uint8_t *data, size_t size);
+//Decodes sprite project file data into context.project
+bool DecodeSpriteProject(ConversionContext &context, const uint8_t *data, size_t size);
+//Encodes project into sprite project file data
+void EncodeSpriteProject(const SpriteProject &project, std::vector<uint8_t> &buffer);
+//Detects format of XML, JSON, or sprite project file data
+SpriteFormat GetSourceFormat(const uint8_t *data, size_t size);
+
+//Writes data to path through a temporary file
+bool WriteOutputFile(std::string path, const void *data, size_t size);
+//Converts sprite file data to XML, JSON, or sprite project file data and passes the pieces of it in order to write_output
+bool DumpSpriteData(ConversionContext &context, const uint8_t *data, size_t size, SpriteFormat format, const std::function<bool(const std::vector<std::string_view> &)> &write_output);
+//Converts sprite file to XML, JSON, or sprite project file
+bool DumpSprite(ConversionContext &context, std::string in_file, std::string out_file, SpriteFormat format);
+//Hashes data with XXH64
+uint64_t HashData(const uint8_t *data, size_t size, uint64_t seed);
+//Converts between XML, JSON, and sprite project files
+bool ConvertProject(ConversionContext &context, std::string in_file, std::string out_file, SpriteFormat format);
+//Converts XML, JSON, or sprite project file to sprite file, using context.cache_dir if set
+bool BuildSprite(ConversionContext &context, std::string in_file, std::string out_file);
+
+#endif
@@ -0,0 +1,177 @@
+#include <new>
+#include <exception>
+#include "spritelib.h"
+#include "spritelib_c.h"
+
+struct SpriteLibContext {
+    ConversionContext context;
+    std::vector<uint8_t> output;
+    size_t output_size; //Excludes null terminator of printed XML
+};
+
+SpriteLibContext *SpriteLib_CreateContext(void)
+{
+    SpriteLibContext *context = new (std::nothrow) SpriteLibContext;
+    if (context) {
+        context->output_size = 0;
+    }
+    return context;
+}
+
+void SpriteLib_DestroyContext(SpriteLibContext *context)
+{
+    delete context;
+}
+
+void ResetContext(SpriteLibContext *context)
+{
+    //Discard project and output from previous calls
+    context->context = ConversionContext();
+    context->output.clear();
+    context->output_size = 0;
+}
+
+template <typename Func>
+int CallSafely(SpriteLibContext *context, Func func)
+{
+    //Exceptions must not cross into C callers
+    try {
+        context->context.error.clear();
+        return func();
+    } catch (const std::bad_alloc &) {
+        context->context.error = "Out of memory.";
+    } catch (const std::exception &e) {
+        context->context.error = e.what();
+    } catch (...) {
+        context->context.error = "Unknown error.";
+    }
+    return 0;
+}
+
+bool CheckProjectCounts(SpriteLibContext *context)
+{
+    //Sprite project header counts are 32-bit
+    const SpriteProject &project = context->context.project;
+    uint64_t frame_count = 0;
+    uint64_t image_count = 0;
+    for (size_t i = 0; i < project.anim_list.size(); i++) {
+        frame_count += project.anim_list[i].size();
+    }
+    for (size_t i = 0; i < project.sprite_list.size(); i++) {
+        image_count += project.sprite_list[i].images.size();
+    }
+    if (project.sprite_list.size() > UINT32_MAX || project.anim_list.size() > UINT32_MAX || frame_count > UINT32_MAX || image_count > UINT32_MAX) {
+        context->context.error = "Too many records for sprite project file. Counts must be at most " + std::to_string(UINT32_MAX) + ".";
+        return false;
+    }
+    return true;
+}
+
+int SpriteLib_DecodeSprite(SpriteLibContext *context, const uint8_t *data, size_t size)
+{
+    return CallSafely(context, [&]() {
+        ResetContext(context);
+        return (int)DecodeSprite(context->context, data, size);
+    });
+}
+
+int SpriteLib_EncodeSprite(SpriteLibContext *context)
+{
+    return CallSafely(context, [&]() {
+        if (!EncodeSprite(context->context, context->output)) {
+            return 0;
+        }
+        context->output_size = context->output.size();
+        return 1;
+    });
+}
+
+int SpriteLib_ParseXML(SpriteLibContext *context, const char *xml, size_t size)
+{
+    return CallSafely(context, [&]() {
+        ResetContext(context);
+        return (int)ParseSpriteXML(context->context, xml, size);
+    });
+}
+
+int SpriteLib_PrintXML(SpriteLibContext *context)
+{
+    return CallSafely(context, [&]() {
+        std::string xml;
+        if (!PrintSpriteXML(context->context, xml)) {
+            return 0;
+        }
+        //Keep null terminator so output can be used as a C string
+        context->output.assign(xml.c_str(), xml.c_str() + xml.size() + 1);
+        context->output_size = xml.size();
+        return 1;
+    });
+}
+
+int SpriteLib_ParseJSON(SpriteLibContext *context, const char *json, size_t size)
+{
+    return CallSafely(context, [&]() {
+        ResetContext(context);
+        return (int)ParseSpriteJSON(context->context, json, size);
+    });
+}
+
+int SpriteLib_PrintJSON(SpriteLibContext *context)
+{
+    return CallSafely(context, [&]() {
+        std::string json;
+        if (!PrintSpriteJSON(context->context, json)) {
+            return 0;
+        }
+        //Keep null terminator so output can be used as a C string
+        context->output.assign(json.c_str(), json.c_str() + json.size() + 1);
+        context->output_size = json.size();
+        return 1;
+    });
+}
+
+int SpriteLib_DecodeProject(SpriteLibContext *context, const uint8_t *data, size_t size)
+{
+    return CallSafely(context, [&]() {
+        ResetContext(context);
+        return (int)DecodeSpriteProject(context->context, data, size);
+    });
+}
+
+int SpriteLib_EncodeProject(SpriteLibContext *context)
+{
+    return CallSafely(context, [&]() {
+        if (!CheckProjectCounts(context)) {
+            return 0;
+        }
+        EncodeSpriteProject(context->context.project, context->output);
+        context->output_size = context->output.size();
+        return 1;
+    });
+}
+
+const uint8_t *SpriteLib_GetOutput(SpriteLibContext *context, size_t *size)
+{
+    if (size) {
+        *size = context->output_size;
+    }
+    return context->output.data();
+}
+
+const char *SpriteLib_GetError(SpriteLibContext *context)
+{
+    return context->context.error.c_str();
+}
+
+size_t SpriteLib_GetWarningCount(SpriteLibContext *context)
+{
+    return context->context.warnings.size();
+}
+
+const char *SpriteLib_GetWarning(SpriteLibContext *context, size_t index)
+{
+    if (index >= context->context.warnings.size()) {
+        return nullptr;
+    }
+    return context->context.warnings[index].c_str();
+}
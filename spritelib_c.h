@@ -0,0 +1,58 @@
+#ifndef SPRITELIB_C_H
+#define SPRITELIB_C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+//Define SPRITELIB_EXPORTS when building spritelib as a DLL and SPRITELIB_DLL when using it
+#if defined(_WIN32) && defined(SPRITELIB_EXPORTS)
+#define SPRITELIB_API __declspec(dllexport)
+#elif defined(_WIN32) && defined(SPRITELIB_DLL)
+#define SPRITELIB_API __declspec(dllimport)
+#elif defined(__GNUC__)
+#define SPRITELIB_API __attribute__((visibility("default")))
+#else
+#define SPRITELIB_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct SpriteLibContext SpriteLibContext;
+
+//Creates a context holding one sprite project
+SPRITELIB_API SpriteLibContext *SpriteLib_CreateContext(void);
+SPRITELIB_API void SpriteLib_DestroyContext(SpriteLibContext *context);
+
+//Functions returning int return 1 on success and 0 on failure
+//Loads sprite file data into the context project
+SPRITELIB_API int SpriteLib_DecodeSprite(SpriteLibContext *context, const uint8_t *data, size_t size);
+//Encodes the context project as sprite file data
+SPRITELIB_API int SpriteLib_EncodeSprite(SpriteLibContext *context);
+//Loads sprite XML text into the context project
+SPRITELIB_API int SpriteLib_ParseXML(SpriteLibContext *context, const char *xml, size_t size);
+//Prints the context project as sprite XML text
+SPRITELIB_API int SpriteLib_PrintXML(SpriteLibContext *context);
+//Loads sprite JSON text into the context project
+SPRITELIB_API int SpriteLib_ParseJSON(SpriteLibContext *context, const char *json, size_t size);
+//Prints the context project as sprite JSON text
+SPRITELIB_API int SpriteLib_PrintJSON(SpriteLibContext *context);
+//Loads sprite project file data into the context project
+SPRITELIB_API int SpriteLib_DecodeProject(SpriteLibContext *context, const uint8_t *data, size_t size);
+//Encodes the context project as sprite project file data
+SPRITELIB_API int SpriteLib_EncodeProject(SpriteLibContext *context);
+
+//Output of the last encode or print, valid until the next call on the context
+SPRITELIB_API const uint8_t *SpriteLib_GetOutput(SpriteLibContext *context, size_t *size);
+//Reason the last call failed
+SPRITELIB_API const char *SpriteLib_GetError(SpriteLibContext *context);
+//Warnings from the last call, such as unknown XML attributes
+SPRITELIB_API size_t SpriteLib_GetWarningCount(SpriteLibContext *context);
+SPRITELIB_API const char *SpriteLib_GetWarning(SpriteLibContext *context, size_t index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
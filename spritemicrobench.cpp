@@ -0,0 +1,361 @@
+#define _CRT_SECURE_NO_WARNINGS //Shut up Visual Studio
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include "spritelib.h"
+#include "spritebinary.h"
+
+//Times sprite file field and record coders in isolation from XML and file costs
+
+struct MicroData {
+    size_t count; //Records processed by one pass
+    std::vector<uint8_t> src; //Random bytes with room for count 28-byte records
+    std::vector<uint8_t> dst; //Output of write benchmarks
+    std::vector<uint16_t> u16s;
+    std::vector<uint32_t> u32s;
+    std::vector<float> floats;
+    std::vector<AnimFrame> frames;
+    std::vector<Image> images;
+    uint64_t sink; //Results folded in so passes cannot be optimized away
+};
+
+struct MicroBenchmark {
+    const char *name;
+    size_t record_size; //Bytes of sprite file covered by one record
+    void (*func)(MicroData &data);
+};
+
+bool IsLittleEndianHost()
+{
+    uint16_t value = 1;
+    uint8_t first_byte;
+    memcpy(&first_byte, &value, 1);
+    return first_byte == 1;
+}
+
+//Primitives called once per field, as the sprite file readers and writers do
+
+void BenchReadU16(MicroData &data)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < data.count; i++) {
+        sum += ReadU16(&data.src[i * 2]);
+    }
+    data.sink += sum;
+}
+
+void BenchReadU32(MicroData &data)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < data.count; i++) {
+        sum += ReadU32(&data.src[i * 4]);
+    }
+    data.sink += sum;
+}
+
+void BenchReadFloat(MicroData &data)
+{
+    float sum = 0.0f;
+    for (size_t i = 0; i < data.count; i++) {
+        sum += ReadFloat(&data.src[i * 4]);
+    }
+    data.sink += (sum != 0.0f);
+}
+
+void BenchWriteU16(MicroData &data)
+{
+    for (size_t i = 0; i < data.count; i++) {
+        WriteU16(&data.dst[i * 2], (uint16_t)i);
+    }
+    data.sink += data.dst[0];
+}
+
+void BenchWriteS32(MicroData &data)
+{
+    for (size_t i = 0; i < data.count; i++) {
+        WriteS32(&data.dst[i * 4], -(int32_t)i);
+    }
+    data.sink += data.dst[0];
+}
+
+void BenchWriteFloat(MicroData &data)
+{
+    for (size_t i = 0; i < data.count; i++) {
+        WriteFloat(&data.dst[i * 4], (float)i);
+    }
+    data.sink += data.dst[0];
+}
+
+//Bulk decoders of field arrays, per field against one copy where host byte order matches
+
+void BenchDecodeU16Fields(MicroData &data)
+{
+    for (size_t i = 0; i < data.count; i++) {
+        data.u16s[i] = ReadU16(&data.src[i * 2]);
+    }
+    data.sink += data.u16s[data.count - 1];
+}
+
+void BenchDecodeU16Copy(MicroData &data)
+{
+    if (IsLittleEndianHost()) {
+        memcpy(data.u16s.data(), data.src.data(), data.count * 2);
+    } else {
+        BenchDecodeU16Fields(data);
+    }
+    data.sink += data.u16s[data.count - 1];
+}
+
+void BenchDecodeU32Fields(MicroData &data)
+{
+    for (size_t i = 0; i < data.count; i++) {
+        data.u32s[i] = ReadU32(&data.src[i * 4]);
+    }
+    data.sink += data.u32s[data.count - 1];
+}
+
+void BenchDecodeU32Copy(MicroData &data)
+{
+    if (IsLittleEndianHost()) {
+        memcpy(data.u32s.data(), data.src.data(), data.count * 4);
+    } else {
+        BenchDecodeU32Fields(data);
+    }
+    data.sink += data.u32s[data.count - 1];
+}
+
+void BenchDecodeFloatFields(MicroData &data)
+{
+    for (size_t i = 0; i < data.count; i++) {
+        data.floats[i] = ReadFloat(&data.src[i * 4]);
+    }
+    data.sink += (data.floats[data.count - 1] != 0.0f);
+}
+
+void BenchDecodeFloatCopy(MicroData &data)
+{
+    if (IsLittleEndianHost()) {
+        memcpy(data.floats.data(), data.src.data(), data.count * 4);
+    } else {
+        BenchDecodeFloatFields(data);
+    }
+    data.sink += (data.floats[data.count - 1] != 0.0f);
+}
+
+//28-byte records through the library coders and through whole-field copies
+
+void BenchReadAnimFrames(MicroData &data)
+{
+    for (size_t i = 0; i < data.count; i++) {
+        ReadAnimFrame(&data.src[i * 28], data.frames[i]);
+    }
+    data.sink += data.frames[data.count - 1].sprite_idx;
+}
+
+void ReadAnimFrameCopy(const uint8_t *src, AnimFrame &frame)
+{
+    //Only valid on little-endian hosts
+    memcpy(&frame.sprite_idx, &src[0], 2);
+    frame.delay = src[2];
+    frame.max_delay = src[3];
+    memcpy(&frame.x_scale, &src[4], 4);
+    memcpy(&frame.y_scale, &src[8], 4);
+    memcpy(&frame.x, &src[12], 4);
+    memcpy(&frame.y, &src[16], 4);
+    memcpy(&frame.angle, &src[20], 2);
+}
+
+void BenchReadAnimFramesCopy(MicroData &data)
+{
+    if (!IsLittleEndianHost()) {
+        BenchReadAnimFrames(data);
+        return;
+    }
+    for (size_t i = 0; i < data.count; i++) {
+        ReadAnimFrameCopy(&data.src[i * 28], data.frames[i]);
+    }
+    data.sink += data.frames[data.count - 1].sprite_idx;
+}
+
+void BenchReadImages(MicroData &data)
+{
+    for (size_t i = 0; i < data.count; i++) {
+        ReadImage(&data.src[i * 28], data.images[i]);
+    }
+    data.sink += data.images[data.count - 1].texture_id;
+}
+
+void ReadImageCopy(const uint8_t *src, Image &image)
+{
+    //Only valid on little-endian hosts, first eight fields are consecutive 16-bit values
+    uint16_t fields[8];
+    memcpy(fields, src, sizeof(fields));
+    image.texture_id = fields[0];
+    image.num_palettes = fields[1];
+    image.x = (int16_t)fields[2];
+    image.y = (int16_t)fields[3];
+    image.src_x = fields[4];
+    image.src_y = fields[5];
+    image.w = fields[6];
+    image.h = fields[7];
+    image.alpha_mode = src[17];
+    memcpy(&image.angle, &src[20], 2);
+    image.blend_mode = src[22];
+    image.bilinear = src[23] != 0;
+    image.flip = src[24];
+}
+
+void BenchReadImagesCopy(MicroData &data)
+{
+    if (!IsLittleEndianHost()) {
+        BenchReadImages(data);
+        return;
+    }
+    for (size_t i = 0; i < data.count; i++) {
+        ReadImageCopy(&data.src[i * 28], data.images[i]);
+    }
+    data.sink += data.images[data.count - 1].texture_id;
+}
+
+void BenchWriteAnimFrames(MicroData &data)
+{
+    for (size_t i = 0; i < data.count; i++) {
+        WriteAnimFrame(&data.dst[i * 28], data.frames[i], 0, (int16_t)(i + 1));
+    }
+    data.sink += data.dst[0];
+}
+
+void BenchWriteImages(MicroData &data)
+{
+    for (size_t i = 0; i < data.count; i++) {
+        WriteImage(&data.dst[i * 28], data.images[i]);
+    }
+    data.sink += data.dst[0];
+}
+
+const MicroBenchmark micro_benchmarks[] = {
+    { "read_u16", 2, BenchReadU16 },
+    { "read_u32", 4, BenchReadU32 },
+    { "read_float", 4, BenchReadFloat },
+    { "write_u16", 2, BenchWriteU16 },
+    { "write_s32", 4, BenchWriteS32 },
+    { "write_float", 4, BenchWriteFloat },
+    { "decode_u16_fields", 2, BenchDecodeU16Fields },
+    { "decode_u16_copy", 2, BenchDecodeU16Copy },
+    { "decode_u32_fields", 4, BenchDecodeU32Fields },
+    { "decode_u32_copy", 4, BenchDecodeU32Copy },
+    { "decode_float_fields", 4, BenchDecodeFloatFields },
+    { "decode_float_copy", 4, BenchDecodeFloatCopy },
+    { "read_anim_frame", 28, BenchReadAnimFrames },
+    { "read_anim_frame_copy", 28, BenchReadAnimFramesCopy },
+    { "read_image", 28, BenchReadImages },
+    { "read_image_copy", 28, BenchReadImagesCopy },
+    { "write_anim_frame", 28, BenchWriteAnimFrames },
+    { "write_image", 28, BenchWriteImages }
+};
+
+void InitMicroData(MicroData &data, size_t count)
+{
+    data.count = count;
+    data.src.resize(count * 28);
+    data.dst.resize(count * 28);
+    //Fixed pseudorandom bytes so every run decodes the same values
+    uint32_t state = 12345;
+    for (size_t i = 0; i < data.src.size(); i++) {
+        state = (state * 1103515245) + 12345;
+        data.src[i] = state >> 24;
+    }
+    data.u16s.resize(count);
+    data.u32s.resize(count);
+    data.floats.resize(count);
+    data.frames.resize(count);
+    data.images.resize(count);
+    //Write benchmarks encode what read benchmarks decode
+    for (size_t i = 0; i < count; i++) {
+        ReadAnimFrame(&data.src[i * 28], data.frames[i]);
+        ReadImage(&data.src[i * 28], data.images[i]);
+    }
+    data.sink = 0;
+}
+
+double TimePasses(const MicroBenchmark &bench, MicroData &data, uint64_t passes)
+{
+    auto start_time = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < passes; i++) {
+        bench.func(data);
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+void RunMicroBenchmark(const MicroBenchmark &bench, MicroData &data, unsigned runs, std::vector<double> &ns_per_record)
+{
+    //Double passes until a run is long enough for the clock to time it well
+    uint64_t passes = 1;
+    while (TimePasses(bench, data, passes) < 0.01 && passes < ((uint64_t)1 << 30)) {
+        passes *= 2;
+    }
+    ns_per_record.clear();
+    for (unsigned i = 0; i < runs; i++) {
+        double time = TimePasses(bench, data, passes);
+        ns_per_record.push_back(time * 1e9 / ((double)passes * data.count));
+    }
+    std::sort(ns_per_record.begin(), ns_per_record.end());
+}
+
+int main(int argc, char **argv)
+{
+    //Get parameters to program
+    std::vector<std::string> args(argv + 1, argv + argc);
+    size_t count = 65535;
+    unsigned runs = 5;
+    std::string filter = "";
+    for (size_t i = 0; i < args.size(); i++) {
+        if (args[i] == "-records" && i + 1 < args.size()) {
+            count = strtoul(args[++i].c_str(), nullptr, 10);
+        } else if (args[i] == "-runs" && i + 1 < args.size()) {
+            runs = strtoul(args[++i].c_str(), nullptr, 10);
+        } else if (args[i] == "-filter" && i + 1 < args.size()) {
+            filter = args[++i];
+        } else {
+            //Write usage statement
+            std::cout << "Usage: " << argv[0] << " [options]" << std::endl;
+            std::cout << "Times sprite file field readers and writers, bulk field decoders, and 28-byte record coders." << std::endl;
+            std::cout << "Results are nanoseconds per record, where primitive benchmarks count one field as a record." << std::endl;
+            std::cout << "Options:" << std::endl;
+            std::cout << "-records n sets the number of records processed per pass (default 65535)" << std::endl;
+            std::cout << "-runs n sets the number of timed runs of each benchmark (default 5)" << std::endl;
+            std::cout << "-filter text runs only benchmarks whose names contain text" << std::endl;
+            return 1;
+        }
+    }
+    if (count == 0 || runs == 0) {
+        std::cout << "Record and run counts must be at least 1." << std::endl;
+        return 1;
+    }
+    MicroData data;
+    InitMicroData(data, count);
+    char line[256];
+    snprintf(line, sizeof(line), "%-22s %6s %12s %14s %12s", "Benchmark", "Bytes", "Min ns/rec", "Median ns/rec", "MB/s");
+    std::cout << line << std::endl;
+    std::vector<double> ns_per_record;
+    for (const MicroBenchmark &bench : micro_benchmarks) {
+        if (!filter.empty() && strstr(bench.name, filter.c_str()) == nullptr) {
+            continue;
+        }
+        RunMicroBenchmark(bench, data, runs, ns_per_record);
+        double median = ns_per_record[ns_per_record.size() / 2];
+        //Bytes of sprite file data per nanosecond is 1000 MB/s
+        snprintf(line, sizeof(line), "%-22s %6zu %12.3f %14.3f %12.1f", bench.name, bench.record_size, ns_per_record[0], median, bench.record_size / median * 1000.0);
+        std::cout << line << std::endl;
+    }
+    //Keep folded results live
+    if (data.sink == 1) {
+        std::cout << std::endl;
+    }
+    return 0;
+}
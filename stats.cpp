@@ -0,0 +1,244 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <cmath>
+#include <algorithm>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#include "spritelib.h"
+#include "json.h"
+#include "stats.h"
+#include "trace.h"
+
+double GetCPUTime(bool whole_process)
+{
+#ifdef _WIN32
+    FILETIME creation_time, exit_time, kernel_time, user_time;
+    BOOL success;
+    if (whole_process) {
+        success = GetProcessTimes(GetCurrentProcess(), &creation_time, &exit_time, &kernel_time, &user_time);
+    } else {
+        success = GetThreadTimes(GetCurrentThread(), &creation_time, &exit_time, &kernel_time, &user_time);
+    }
+    if (!success) {
+        return 0.0;
+    }
+    //File times count 100 nanosecond intervals
+    uint64_t kernel = ((uint64_t)kernel_time.dwHighDateTime << 32) | kernel_time.dwLowDateTime;
+    uint64_t user = ((uint64_t)user_time.dwHighDateTime << 32) | user_time.dwLowDateTime;
+    return (kernel + user) * 1e-7;
+#else
+    timespec time;
+    if (clock_gettime(whole_process ? CLOCK_PROCESS_CPUTIME_ID : CLOCK_THREAD_CPUTIME_ID, &time) != 0) {
+        return 0.0;
+    }
+    return time.tv_sec + (time.tv_nsec * 1e-9);
+#endif
+}
+
+bool UsesProcessCPUTime(const ConversionContext &context)
+{
+    //Conversions spreading over threads run one at a time so the whole process is theirs,
+    //while single threaded conversions may run next to others and only own their thread
+    return context.num_threads > 1;
+}
+
+PhaseScope::PhaseScope(ConversionContext &context, ConversionPhase phase) : context(context), phase(phase)
+{
+    if (context.trace) {
+        AddTraceEvent(*context.trace, GetPhaseName(phase), "phase", 'B');
+    }
+    start_wall_time = std::chrono::steady_clock::now();
+    start_cpu_time = GetCPUTime(UsesProcessCPUTime(context));
+    start_counters.valid = false;
+    if (context.perf_counters) {
+        ReadPerfCounters(start_counters);
+    }
+    //Allocations of conversion threads are counted like their CPU time
+    mem_report = context.mem_report && IsAllocationTrackingEnabled();
+    if (mem_report) {
+        outer_peak_live_bytes = ResetPeakLiveBytes(UsesProcessCPUTime(context));
+        ReadAllocationCounts(start_allocs, UsesProcessCPUTime(context));
+    }
+}
+
+PhaseScope::~PhaseScope()
+{
+    PhaseStats &stats = context.stats.phases[phase];
+    stats.calls++;
+    stats.wall_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start_wall_time).count();
+    stats.cpu_time += GetCPUTime(UsesProcessCPUTime(context)) - start_cpu_time;
+    if (start_counters.valid) {
+        PerfCounterValues end_counters;
+        ReadPerfCounters(end_counters);
+        if (end_counters.valid) {
+            for (size_t i = 0; i < PERF_COUNTER_COUNT; i++) {
+                stats.counters[i] += end_counters.values[i] - start_counters.values[i];
+            }
+            context.stats.has_perf_counters = true;
+        }
+    }
+    if (mem_report) {
+        AllocationCounts end_allocs;
+        ReadAllocationCounts(end_allocs, UsesProcessCPUTime(context));
+        stats.allocs += end_allocs.allocs - start_allocs.allocs;
+        stats.alloc_bytes += end_allocs.bytes - start_allocs.bytes;
+        uint64_t peak_heap_bytes = (uint64_t)std::max<int64_t>(end_allocs.peak_live_bytes - start_allocs.live_bytes, 0);
+        stats.peak_heap_bytes = std::max(stats.peak_heap_bytes, peak_heap_bytes);
+        stats.peak_rss_bytes = std::max(stats.peak_rss_bytes, GetPeakResidentBytes());
+        RestorePeakLiveBytes(outer_peak_live_bytes, UsesProcessCPUTime(context));
+        context.stats.has_mem_report = true;
+    }
+    if (context.trace) {
+        AddTraceEvent(*context.trace, GetPhaseName(phase), "phase", 'E');
+    }
+}
+
+const char *GetPhaseName(ConversionPhase phase)
+{
+    const char *names[PHASE_COUNT] = {
+        "read_file",
+        "cache",
+        "verify",
+        "read_anims",
+        "read_sprites",
+        "parse",
+        "resolve",
+        "bounds",
+        "print",
+        "encode",
+        "write_file"
+    };
+    return names[phase];
+}
+
+void AddConversionStats(ConversionStats &total, const ConversionStats &stats)
+{
+    for (size_t i = 0; i < PHASE_COUNT; i++) {
+        total.phases[i].calls += stats.phases[i].calls;
+        total.phases[i].wall_time += stats.phases[i].wall_time;
+        total.phases[i].cpu_time += stats.phases[i].cpu_time;
+        for (size_t j = 0; j < PERF_COUNTER_COUNT; j++) {
+            total.phases[i].counters[j] += stats.phases[i].counters[j];
+        }
+        total.phases[i].allocs += stats.phases[i].allocs;
+        total.phases[i].alloc_bytes += stats.phases[i].alloc_bytes;
+        total.phases[i].peak_heap_bytes = std::max(total.phases[i].peak_heap_bytes, stats.phases[i].peak_heap_bytes);
+        total.phases[i].peak_rss_bytes = std::max(total.phases[i].peak_rss_bytes, stats.phases[i].peak_rss_bytes);
+    }
+    total.files += stats.files;
+    total.sprites += stats.sprites;
+    total.anims += stats.anims;
+    total.frames += stats.frames;
+    total.images += stats.images;
+    total.bytes_in += stats.bytes_in;
+    total.bytes_out += stats.bytes_out;
+    total.has_perf_counters = total.has_perf_counters || stats.has_perf_counters;
+    total.has_mem_report = total.has_mem_report || stats.has_mem_report;
+}
+
+void PrintStatsText(const ConversionStats &stats, std::string &text)
+{
+    char line[256];
+    snprintf(line, sizeof(line), "%-14s %10s %12s %12s", "Phase", "Calls", "Wall ms", "CPU ms");
+    text += line;
+    if (stats.has_perf_counters) {
+        snprintf(line, sizeof(line), " %14s %14s %6s %12s %12s", "Cycles", "Instructions", "IPC", "Cache misses", "Branch misses");
+        text += line;
+    }
+    if (stats.has_mem_report) {
+        snprintf(line, sizeof(line), " %12s %12s %12s %12s", "Allocs", "Alloc KB", "Peak heap KB", "Peak RSS KB");
+        text += line;
+    }
+    text += '\n';
+    for (size_t i = 0; i < PHASE_COUNT; i++) {
+        const PhaseStats &phase = stats.phases[i];
+        //Skip phases the conversions did not go through
+        if (phase.calls == 0) {
+            continue;
+        }
+        snprintf(line, sizeof(line), "%-14s %10llu %12.3f %12.3f", GetPhaseName((ConversionPhase)i), (unsigned long long)phase.calls, phase.wall_time * 1000.0, phase.cpu_time * 1000.0);
+        text += line;
+        if (stats.has_perf_counters) {
+            //Instructions per cycle shows whether a phase is stalled
+            const uint64_t *counters = phase.counters;
+            double ipc = (counters[PERF_CYCLES] != 0) ? (double)counters[PERF_INSTRUCTIONS] / counters[PERF_CYCLES] : 0.0;
+            snprintf(line, sizeof(line), " %14llu %14llu %6.2f %12llu %12llu", (unsigned long long)counters[PERF_CYCLES], (unsigned long long)counters[PERF_INSTRUCTIONS], ipc, (unsigned long long)counters[PERF_CACHE_MISSES], (unsigned long long)counters[PERF_BRANCH_MISSES]);
+            text += line;
+        }
+        if (stats.has_mem_report) {
+            snprintf(line, sizeof(line), " %12llu %12llu %12llu %12llu", (unsigned long long)phase.allocs, (unsigned long long)(phase.alloc_bytes / 1024), (unsigned long long)(phase.peak_heap_bytes / 1024), (unsigned long long)(phase.peak_rss_bytes / 1024));
+            text += line;
+        }
+        text += '\n';
+    }
+    snprintf(line, sizeof(line), "Files: %llu, sprites: %llu, anims: %llu, frames: %llu, images: %llu\n", (unsigned long long)stats.files, (unsigned long long)stats.sprites, (unsigned long long)stats.anims, (unsigned long long)stats.frames, (unsigned long long)stats.images);
+    text += line;
+    snprintf(line, sizeof(line), "Bytes in: %llu, bytes out: %llu\n", (unsigned long long)stats.bytes_in, (unsigned long long)stats.bytes_out);
+    text += line;
+}
+
+double RoundMilliseconds(double seconds)
+{
+    //Clocks are not precise below microseconds so leave out digits beyond them
+    return std::round(seconds * 1000000.0) / 1000.0;
+}
+
+void PrintStatsJSON(const ConversionStats &stats, std::string &json)
+{
+    //Every phase is written so dashboards see a fixed set of keys
+    json += "{\n    ";
+    WriteJSONKey(json, "phases");
+    json += '{';
+    for (size_t i = 0; i < PHASE_COUNT; i++) {
+        const PhaseStats &phase = stats.phases[i];
+        json += (i == 0) ? "\n        " : ",\n        ";
+        WriteJSONKey(json, GetPhaseName((ConversionPhase)i));
+        json += '{';
+        WriteJSONKey(json, "calls");
+        WriteJSONUnsigned(json, phase.calls);
+        json += ", ";
+        WriteJSONKey(json, "wall_ms");
+        WriteJSONDouble(json, RoundMilliseconds(phase.wall_time));
+        json += ", ";
+        WriteJSONKey(json, "cpu_ms");
+        WriteJSONDouble(json, RoundMilliseconds(phase.cpu_time));
+        if (stats.has_perf_counters) {
+            for (size_t j = 0; j < PERF_COUNTER_COUNT; j++) {
+                json += ", ";
+                WriteJSONKey(json, GetPerfCounterName((PerfCounter)j));
+                WriteJSONUnsigned(json, phase.counters[j]);
+            }
+        }
+        if (stats.has_mem_report) {
+            const char *memory_names[4] = { "allocs", "alloc_bytes", "peak_heap_bytes", "peak_rss_bytes" };
+            uint64_t memory_counts[4] = { phase.allocs, phase.alloc_bytes, phase.peak_heap_bytes, phase.peak_rss_bytes };
+            for (size_t j = 0; j < 4; j++) {
+                json += ", ";
+                WriteJSONKey(json, memory_names[j]);
+                WriteJSONUnsigned(json, memory_counts[j]);
+            }
+        }
+        json += '}';
+    }
+    json += "\n    }";
+    const char *count_names[7] = { "files", "sprites", "anims", "frames", "images", "bytes_in", "bytes_out" };
+    uint64_t counts[7] = { stats.files, stats.sprites, stats.anims, stats.frames, stats.images, stats.bytes_in, stats.bytes_out };
+    for (size_t i = 0; i < 7; i++) {
+        json += ",\n    ";
+        WriteJSONKey(json, count_names[i]);
+        WriteJSONUnsigned(json, counts[i]);
+    }
+    json += ",\n    ";
+    WriteJSONKey(json, "perf_counters");
+    json += stats.has_perf_counters ? "true" : "false";
+    json += ",\n    ";
+    WriteJSONKey(json, "mem_report");
+    json += stats.has_mem_report ? "true" : "false";
+    json += "\n}\n";
+}
@@ -0,0 +1,78 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include <string>
+#include <chrono>
+#include "perf.h"
+#include "memtrack.h"
+
+struct ConversionContext;
+
+//Steps of a conversion which are timed separately
+enum ConversionPhase {
+    PHASE_READ_FILE, //Opening or reading input file
+    PHASE_CACHE, //Hashing input and copying to or from build cache
+    PHASE_VERIFY, //Reading and verifying sprite file header and ranges
+    PHASE_READ_ANIMS, //Decoding animations and frames
+    PHASE_READ_SPRITES, //Decoding sprites and images
+    PHASE_PARSE, //Parsing XML or JSON sprites and animations
+    PHASE_RESOLVE, //Building sprite lookup and resolving frame sprite names
+    PHASE_BOUNDS, //Calculating sprite bounding rectangles
+    PHASE_PRINT, //Printing XML or JSON
+    PHASE_ENCODE, //Writing sections of sprite or sprite project file
+    PHASE_WRITE_FILE, //Writing output file
+    PHASE_COUNT
+};
+
+struct PhaseStats {
+    uint64_t calls;
+    double wall_time; //Seconds
+    double cpu_time; //Seconds
+    uint64_t counters[PERF_COUNTER_COUNT]; //Hardware counts if context.perf_counters is set
+    uint64_t allocs; //Heap allocations if context.mem_report is set
+    uint64_t alloc_bytes;
+    uint64_t peak_heap_bytes; //Highest heap growth over live bytes at start of any call
+    uint64_t peak_rss_bytes; //Process peak resident set size seen at end of calls
+};
+
+struct ConversionStats {
+    PhaseStats phases[PHASE_COUNT];
+    uint64_t files; //Conversions started
+    uint64_t sprites;
+    uint64_t anims;
+    uint64_t frames;
+    uint64_t images;
+    uint64_t bytes_in;
+    uint64_t bytes_out;
+    bool has_perf_counters; //Some phase was measured with hardware counters
+    bool has_mem_report; //Some phase was measured with allocation counts
+};
+
+//Adds time of phase to context.stats for the lifetime of the scope, tracing it if context.trace is set
+struct PhaseScope {
+    ConversionContext &context;
+    ConversionPhase phase;
+    std::chrono::steady_clock::time_point start_wall_time;
+    double start_cpu_time;
+    PerfCounterValues start_counters;
+    bool mem_report;
+    AllocationCounts start_allocs;
+    int64_t outer_peak_live_bytes; //Peak of enclosing scope, restored at end
+
+    PhaseScope(ConversionContext &context, ConversionPhase phase);
+    ~PhaseScope();
+};
+
+//Name of phase in reports
+const char *GetPhaseName(ConversionPhase phase);
+//Adds stats of one conversion to total
+void AddConversionStats(ConversionStats &total, const ConversionStats &stats);
+//Prints stats as a table
+void PrintStatsText(const ConversionStats &stats, std::string &text);
+//Converts seconds to milliseconds without digits below clock precision
+double RoundMilliseconds(double seconds);
+//Prints stats as a JSON object
+void PrintStatsJSON(const ConversionStats &stats, std::string &json);
+
+#endif
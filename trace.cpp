@@ -0,0 +1,95 @@
+#include <stdint.h>
+#include <string>
+#include <cmath>
+#include <atomic>
+#include <set>
+#include "json.h"
+#include "trace.h"
+
+void InitTraceRecorder(TraceRecorder &trace)
+{
+    trace.events.clear();
+    trace.start_time = std::chrono::steady_clock::now();
+}
+
+uint32_t GetTraceThreadID()
+{
+    //Number threads in the order they first record an event
+    static std::atomic<uint32_t> next_thread_id(1);
+    thread_local uint32_t thread_id = next_thread_id.fetch_add(1);
+    return thread_id;
+}
+
+void AddTraceEvent(TraceRecorder &trace, std::string name, const char *category, char type)
+{
+    TraceEvent event;
+    event.name = std::move(name);
+    event.category = category;
+    event.type = type;
+    event.thread_id = GetTraceThreadID();
+    //Keep whole nanoseconds so times print without rounding noise
+    double time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - trace.start_time).count();
+    event.time = std::round(time * 1000.0) / 1000.0;
+    std::lock_guard<std::mutex> lock(trace.mutex);
+    trace.events.push_back(std::move(event));
+}
+
+TraceScope::TraceScope(TraceRecorder *trace, std::string name, const char *category) : trace(trace), category(category)
+{
+    if (trace) {
+        this->name = name;
+        AddTraceEvent(*trace, std::move(name), category, 'B');
+    }
+}
+
+TraceScope::~TraceScope()
+{
+    if (trace) {
+        AddTraceEvent(*trace, std::move(name), category, 'E');
+    }
+}
+
+void PrintTraceJSON(TraceRecorder &trace, std::string &json)
+{
+    std::lock_guard<std::mutex> lock(trace.mutex);
+    json += "{\"traceEvents\": [";
+    //Name every thread seen so viewers do not show bare numbers
+    std::set<uint32_t> thread_ids;
+    for (size_t i = 0; i < trace.events.size(); i++) {
+        thread_ids.insert(trace.events[i].thread_id);
+    }
+    bool first = true;
+    for (uint32_t thread_id : thread_ids) {
+        json += first ? "\n" : ",\n";
+        first = false;
+        json += "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, ";
+        WriteJSONKey(json, "tid");
+        WriteJSONUnsigned(json, thread_id);
+        json += ", \"args\": {";
+        WriteJSONKey(json, "name");
+        WriteJSONString(json, "Thread " + std::to_string(thread_id));
+        json += "}}";
+    }
+    for (size_t i = 0; i < trace.events.size(); i++) {
+        const TraceEvent &event = trace.events[i];
+        json += first ? "\n" : ",\n";
+        first = false;
+        json += '{';
+        WriteJSONKey(json, "name");
+        WriteJSONString(json, event.name);
+        json += ", ";
+        WriteJSONKey(json, "cat");
+        WriteJSONString(json, event.category);
+        json += ", ";
+        WriteJSONKey(json, "ph");
+        WriteJSONString(json, std::string_view(&event.type, 1));
+        json += ", ";
+        WriteJSONKey(json, "ts");
+        WriteJSONDouble(json, event.time);
+        json += ", \"pid\": 1, ";
+        WriteJSONKey(json, "tid");
+        WriteJSONUnsigned(json, event.thread_id);
+        json += '}';
+    }
+    json += "\n], \"displayTimeUnit\": \"ms\"}\n";
+}
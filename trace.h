@@ -0,0 +1,43 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+
+struct TraceEvent {
+    std::string name;
+    const char *category;
+    char type; //B for begin or E for end
+    uint32_t thread_id;
+    double time; //Microseconds since recording started
+};
+
+//Events shared by every conversion of a run, safe to add to from any thread
+struct TraceRecorder {
+    std::mutex mutex;
+    std::vector<TraceEvent> events;
+    std::chrono::steady_clock::time_point start_time;
+};
+
+//Begins and ends an event for the lifetime of the scope if trace is set
+struct TraceScope {
+    TraceRecorder *trace;
+    std::string name;
+    const char *category;
+
+    TraceScope(TraceRecorder *trace, std::string name, const char *category);
+    ~TraceScope();
+};
+
+//Starts recording with times relative to now
+void InitTraceRecorder(TraceRecorder &trace);
+//Small number identifying calling thread in traces
+uint32_t GetTraceThreadID();
+void AddTraceEvent(TraceRecorder &trace, std::string name, const char *category, char type);
+//Prints events in Chrome trace event format
+void PrintTraceJSON(TraceRecorder &trace, std::string &json);
+
+#endif
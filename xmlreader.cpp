@@ -0,0 +1,291 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include "xmlreader.h"
+
+void InitXMLReader(XMLReader &reader, const char *data, size_t size)
+{
+    reader.start = data;
+    reader.pos = data;
+    reader.end = data + size;
+    //Skip UTF-8 byte order mark
+    if (size >= 3 && memcmp(data, "\xEF\xBB\xBF", 3) == 0) {
+        reader.pos += 3;
+    }
+    reader.open_elements.clear();
+    reader.name = std::string_view();
+    reader.tag_start = nullptr;
+    reader.attributes.clear();
+    reader.decoded_values.clear();
+    reader.pending_end = false;
+    reader.error.clear();
+}
+
+size_t GetXMLLine(const XMLReader &reader)
+{
+    size_t line = 1;
+    for (const char *c = reader.start; c < reader.pos; c++) {
+        if (*c == '\n') {
+            line++;
+        }
+    }
+    return line;
+}
+
+XMLEventType SetXMLError(XMLReader &reader, std::string error)
+{
+    reader.error = "Line " + std::to_string(GetXMLLine(reader)) + ": " + error;
+    return XML_EVENT_ERROR;
+}
+
+bool IsXMLSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+void SkipXMLSpace(XMLReader &reader)
+{
+    while (reader.pos < reader.end && IsXMLSpace(*reader.pos)) {
+        reader.pos++;
+    }
+}
+
+bool SkipXMLPast(XMLReader &reader, const char *terminator)
+{
+    //Move reader after next terminator
+    size_t length = strlen(terminator);
+    const char *found = std::search(reader.pos, reader.end, terminator, terminator + length);
+    if (found == reader.end) {
+        reader.pos = reader.end;
+        return false;
+    }
+    reader.pos = found + length;
+    return true;
+}
+
+std::string_view ReadXMLName(XMLReader &reader)
+{
+    const char *name_start = reader.pos;
+    while (reader.pos < reader.end && !IsXMLSpace(*reader.pos) && !strchr("/>=<\"'", *reader.pos)) {
+        reader.pos++;
+    }
+    return std::string_view(name_start, reader.pos - name_start);
+}
+
+void AppendUTF8(std::string &text, uint32_t code)
+{
+    if (code < 0x80) {
+        text += (char)code;
+    } else if (code < 0x800) {
+        text += (char)(0xC0 | (code >> 6));
+        text += (char)(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+        text += (char)(0xE0 | (code >> 12));
+        text += (char)(0x80 | ((code >> 6) & 0x3F));
+        text += (char)(0x80 | (code & 0x3F));
+    } else {
+        text += (char)(0xF0 | (code >> 18));
+        text += (char)(0x80 | ((code >> 12) & 0x3F));
+        text += (char)(0x80 | ((code >> 6) & 0x3F));
+        text += (char)(0x80 | (code & 0x3F));
+    }
+}
+
+bool DecodeXMLEntities(std::string_view value, std::string &text)
+{
+    const char *names[5] = { "lt;", "gt;", "amp;", "quot;", "apos;" };
+    const char chars[5] = { '<', '>', '&', '"', '\'' };
+    size_t i = 0;
+    while (i < value.size()) {
+        if (value[i] != '&') {
+            text += value[i++];
+            continue;
+        }
+        std::string_view entity = value.substr(i + 1);
+        if (entity.size() > 1 && entity[0] == '#') {
+            //Decode character reference
+            size_t semicolon = entity.find(';');
+            if (semicolon == std::string_view::npos || semicolon < 2) {
+                return false;
+            }
+            bool hex = (entity[1] == 'x');
+            std::string digits(entity.substr(hex ? 2 : 1, semicolon - (hex ? 2 : 1)));
+            char *digits_end;
+            unsigned long code = strtoul(digits.c_str(), &digits_end, hex ? 16 : 10);
+            if (digits.empty() || *digits_end != '\0' || code == 0 || code > 0x10FFFF) {
+                return false;
+            }
+            AppendUTF8(text, code);
+            i += semicolon + 2;
+            continue;
+        }
+        //Decode named entity
+        bool found = false;
+        for (size_t j = 0; j < 5; j++) {
+            if (entity.substr(0, strlen(names[j])) == names[j]) {
+                text += chars[j];
+                i += strlen(names[j]) + 1;
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            return false;
+        }
+    }
+    return true;
+}
+
+XMLEventType ReadXMLStartElement(XMLReader &reader)
+{
+    reader.name = ReadXMLName(reader);
+    if (reader.name.empty()) {
+        return SetXMLError(reader, "Missing element name.");
+    }
+    reader.attributes.clear();
+    reader.decoded_values.clear();
+    while (true) {
+        SkipXMLSpace(reader);
+        if (reader.pos >= reader.end) {
+            return SetXMLError(reader, "Unterminated element " + std::string(reader.name) + ".");
+        }
+        if (*reader.pos == '>') {
+            //Children follow
+            reader.pos++;
+            reader.open_elements.push_back(reader.name);
+            return XML_EVENT_START;
+        }
+        if (*reader.pos == '/') {
+            //Element has no children
+            if (reader.pos + 1 >= reader.end || reader.pos[1] != '>') {
+                return SetXMLError(reader, "Expected > after / in element " + std::string(reader.name) + ".");
+            }
+            reader.pos += 2;
+            reader.pending_end = true;
+            return XML_EVENT_START;
+        }
+        //Read attribute
+        XMLReaderAttribute attribute;
+        attribute.name = ReadXMLName(reader);
+        if (attribute.name.empty()) {
+            return SetXMLError(reader, "Invalid attribute in element " + std::string(reader.name) + ".");
+        }
+        SkipXMLSpace(reader);
+        if (reader.pos >= reader.end || *reader.pos != '=') {
+            return SetXMLError(reader, "Expected = after attribute " + std::string(attribute.name) + ".");
+        }
+        reader.pos++;
+        SkipXMLSpace(reader);
+        if (reader.pos >= reader.end || (*reader.pos != '"' && *reader.pos != '\'')) {
+            return SetXMLError(reader, "Expected quoted value for attribute " + std::string(attribute.name) + ".");
+        }
+        char quote = *reader.pos++;
+        const char *value_start = reader.pos;
+        const char *value_end = (const char *)memchr(value_start, quote, reader.end - value_start);
+        if (!value_end) {
+            return SetXMLError(reader, "Unterminated value for attribute " + std::string(attribute.name) + ".");
+        }
+        attribute.value = std::string_view(value_start, value_end - value_start);
+        reader.pos = value_end + 1;
+        if (attribute.value.find('&') != std::string_view::npos) {
+            //Only values with entities need a copy
+            reader.decoded_values.emplace_back();
+            if (!DecodeXMLEntities(attribute.value, reader.decoded_values.back())) {
+                return SetXMLError(reader, "Invalid entity in attribute " + std::string(attribute.name) + ".");
+            }
+            attribute.value = reader.decoded_values.back();
+        }
+        reader.attributes.push_back(attribute);
+    }
+}
+
+XMLEventType ReadXMLEvent(XMLReader &reader)
+{
+    if (reader.pending_end) {
+        //Report end of self-closing element
+        reader.pending_end = false;
+        return XML_EVENT_END;
+    }
+    while (true) {
+        //Skip text before next markup
+        const char *markup = (const char *)memchr(reader.pos, '<', reader.end - reader.pos);
+        if (!markup) {
+            reader.pos = reader.end;
+            if (!reader.open_elements.empty()) {
+                return SetXMLError(reader, "Element " + std::string(reader.open_elements.back()) + " is not closed.");
+            }
+            return XML_EVENT_DOCUMENT_END;
+        }
+        reader.tag_start = markup;
+        reader.pos = markup + 1;
+        std::string_view rest(reader.pos, reader.end - reader.pos);
+        if (rest.substr(0, 3) == "!--") {
+            //Skip comment
+            if (!SkipXMLPast(reader, "-->")) {
+                return SetXMLError(reader, "Unterminated comment.");
+            }
+        } else if (rest.substr(0, 8) == "![CDATA[") {
+            //Skip character data
+            if (!SkipXMLPast(reader, "]]>")) {
+                return SetXMLError(reader, "Unterminated CDATA section.");
+            }
+        } else if (rest.substr(0, 1) == "?") {
+            //Skip declaration or processing instruction
+            if (!SkipXMLPast(reader, "?>")) {
+                return SetXMLError(reader, "Unterminated declaration.");
+            }
+        } else if (rest.substr(0, 1) == "!") {
+            //Skip document type including internal subset
+            int depth = 0;
+            while (reader.pos < reader.end && (*reader.pos != '>' || depth != 0)) {
+                if (*reader.pos == '[') {
+                    depth++;
+                } else if (*reader.pos == ']') {
+                    depth--;
+                }
+                reader.pos++;
+            }
+            if (reader.pos >= reader.end) {
+                return SetXMLError(reader, "Unterminated document type.");
+            }
+            reader.pos++;
+        } else if (rest.substr(0, 1) == "/") {
+            //Read end tag
+            reader.pos++;
+            reader.name = ReadXMLName(reader);
+            SkipXMLSpace(reader);
+            if (reader.pos >= reader.end || *reader.pos != '>') {
+                return SetXMLError(reader, "Unterminated end tag " + std::string(reader.name) + ".");
+            }
+            reader.pos++;
+            if (reader.open_elements.empty() || reader.open_elements.back() != reader.name) {
+                return SetXMLError(reader, "Mismatched end tag " + std::string(reader.name) + ".");
+            }
+            reader.open_elements.pop_back();
+            return XML_EVENT_END;
+        } else {
+            return ReadXMLStartElement(reader);
+        }
+    }
+}
+
+bool SkipXMLElement(XMLReader &reader)
+{
+    //Count nested elements until current one ends
+    size_t depth = 1;
+    while (depth != 0) {
+        XMLEventType event = ReadXMLEvent(reader);
+        if (event == XML_EVENT_START) {
+            depth++;
+        } else if (event == XML_EVENT_END) {
+            depth--;
+        } else if (event == XML_EVENT_DOCUMENT_END) {
+            reader.error = "Unexpected end of document.";
+            return false;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,49 @@
+#ifndef XMLREADER_H
+#define XMLREADER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+
+enum XMLEventType {
+    XML_EVENT_START, //Start of element, name and attributes are valid
+    XML_EVENT_END, //End of element, name is valid
+    XML_EVENT_DOCUMENT_END,
+    XML_EVENT_ERROR
+};
+
+struct XMLReaderAttribute {
+    std::string_view name;
+    std::string_view value; //Entities are already decoded
+};
+
+struct XMLReader {
+    const char *start;
+    const char *pos;
+    const char *end;
+    std::vector<std::string_view> open_elements; //Names of elements which have not ended
+    std::string_view name; //Name of current element
+    const char *tag_start; //Position of < starting current element tag
+    std::vector<XMLReaderAttribute> attributes; //Attributes of current start element
+    std::deque<std::string> decoded_values; //Storage for attribute values containing entities
+    bool pending_end; //Current element was self-closing
+    std::string error;
+};
+
+//Starts reading XML text without copying it
+void InitXMLReader(XMLReader &reader, const char *data, size_t size);
+//Reads next element start or end, skipping text, comments, and declarations
+XMLEventType ReadXMLEvent(XMLReader &reader);
+//Skips children and end of element which just started
+bool SkipXMLElement(XMLReader &reader);
+//Line number of current reader position
+size_t GetXMLLine(const XMLReader &reader);
+//Checks for XML whitespace character
+bool IsXMLSpace(char c);
+//Appends code point to text as UTF-8
+void AppendUTF8(std::string &text, uint32_t code);
+
+#endif